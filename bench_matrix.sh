@@ -0,0 +1,203 @@
+#!/bin/bash
+# Benchmark matrix: build Dhrystone, CoreMark and LINPACK with every compiler
+# and configuration declared below, run every build $REPS times and print the
+# median score, its spread and the code size (text segment) of each binary.
+#
+#   ./bench_matrix.sh
+#   COMPILERS=gcc BENCHMARKS="coremark linpackdp" REPS=5 ./bench_matrix.sh
+#
+# The table is also written to $OUT/results.csv. The build and run logs of
+# every cell are kept in $OUT/<compiler>/<config>/ so a failure can be looked at.
+# Compilers that are not installed are skipped.
+
+cd "$(dirname "$0")" || exit 1
+set -o pipefail
+
+COMPILERS=${COMPILERS:-"gcc clang"}
+BENCHMARKS=${BENCHMARKS:-"dhrystone coremark linpackdp linpacksp"}
+REPS=${REPS:-3}
+OUT=${OUT:-bench_matrix}
+LLVM_PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+
+# Arguments of the measured runs: Dhrystone and CoreMark calibrate themselves
+# to at least 3 and 10 seconds, LINPACK sizes its last run to 10 s.
+DHRY_ARGS=${DHRY_ARGS:-"0 1 1"}
+CM_ARGS=${CM_ARGS:-"0x0 0x0 0x66 0 7 1 2000"}
+LP_ARGS=${LP_ARGS:-"200"}
+
+# Name and flags of every configuration. A "pgo" flag builds twice: first
+# instrumented for a training run, then again with the collected profile.
+CONFIGS=${CONFIGS:-"
+O2                  -O2
+O3                  -O3
+O3-register         -O3 -DREG=register
+O3-native           -O3 -march=native
+O3-lto              -O3 -flto
+O3-pgo              -O3 pgo
+O3-native-lto-pgo   -O3 -march=native -flto pgo
+"}
+
+# build <bench> <cc> <flags> <binary>
+build()
+{
+    case $1 in
+    dhrystone)
+        $2 $3 -DMONOTONIC -Idhrystone/include dhrystone/src/dhry_1.c \
+            dhrystone/src/dhry_2.c -o $4 ;;
+    coremark)
+        $2 $3 -Icoremark/include -DUINTPTR_TYPE -DPERFORMANCE_RUN=1 \
+            -DCOMPILER_FLAGS="\"$3\"" -DMEM_LOCATION="\"Main memory (heap)\"" \
+            coremark/src/core_list_join.c coremark/src/core_main.c \
+            coremark/src/core_matrix.c coremark/src/core_state.c \
+            coremark/src/core_util.c coremark/src/core_portme.c -o $4 ;;
+    linpackdp)
+        $2 $3 linpack/src/linpack.c -o $4 -lm -lpthread ;;
+    linpacksp)
+        $2 $3 -DSP linpack/src/linpack.c -o $4 -lm -lpthread ;;
+    esac
+}
+
+# train <bench> <binary>: short run feeding the profile of a PGO build
+train()
+{
+    case $1 in
+    dhrystone) $2 2000000 1 1 ;;
+    coremark)  $2 0x0 0x0 0x66 2000 7 1 2000 ;;
+    linpack*)  $2 100 ;;
+    esac
+}
+
+# run <bench> <binary>: print the score of one measured run; fails if the
+# benchmark exits non-zero or its output does not validate
+run()
+{
+    case $1 in
+    dhrystone)
+        $2 $DHRY_ARGS | awk '/^DMIPS:/ {s = $2} END {if (s != "") print s}' ;;
+    coremark)
+        $2 $CM_ARGS | awk '/ERROR!.*crc/ {bad = 1}
+            /^Iterations\/Sec/ {s = $3}
+            END {if (!bad && s != "") print s}' ;;
+    linpack*)
+        $2 $LP_ARGS | awk 'NF == 6 && $1 ~ /^[0-9]+$/ {s = $6 / 1000}
+            END {if (s != "") print s}' ;;
+    esac
+}
+
+unit()
+{
+    case $1 in
+    dhrystone) echo DMIPS ;;
+    coremark)  echo Iter/s ;;
+    linpack*)  echo MFLOPS ;;
+    esac
+}
+
+# pgo_flags <cc> <dir> generate|use
+pgo_flags()
+{
+    case $1 in
+    *clang*)
+        if [ $3 = generate ]; then
+            echo "-fprofile-generate=$2"
+        else
+            echo "-fprofile-use=$2/default.profdata"
+        fi ;;
+    *)
+        if [ $3 = generate ]; then
+            echo "-fprofile-generate=$2"
+        else
+            echo "-fprofile-use=$2 -Wno-missing-profile"
+        fi ;;
+    esac
+}
+
+# cell <cc> <config> <flags> <bench>: build, run and report one table cell
+cell()
+{
+    local cc=$1 conf=$2 flags=$3 bench=$4 pgo= dir bin log status scores
+    local median min max size spread i s
+
+    dir=$OUT/$cc/$conf
+    bin=$dir/$bench
+    log=$dir/$bench.log
+    mkdir -p $dir
+    : > $log
+
+    case " $flags " in
+    *" pgo "*)
+        pgo=$dir/$bench.prof
+        case $pgo in /*) ;; *) pgo=$PWD/$pgo ;; esac
+        flags=$(echo " $flags " | sed 's/ pgo / /')
+        rm -rf $pgo
+        mkdir -p $pgo
+        echo "== build (instrumented) ==" >> $log
+        build $bench $cc "$flags $(pgo_flags $cc $pgo generate)" $bin >> $log 2>&1 &&
+            echo "== training run ==" >> $log &&
+            train $bench $bin >> $log 2>&1 &&
+            case $cc in
+            *clang*) $LLVM_PROFDATA merge -o $pgo/default.profdata $pgo/*.profraw >> $log 2>&1 ;;
+            esac
+        [ $? -eq 0 ] || { status="PGO training failed"; }
+        flags="$flags $(pgo_flags $cc $pgo use)"
+        ;;
+    esac
+
+    if [ -z "$status" ]; then
+        echo "== build ==" >> $log
+        build $bench $cc "$flags" $bin >> $log 2>&1 || status="build failed"
+    fi
+
+    scores=
+    if [ -z "$status" ]; then
+        for i in $(seq $REPS); do
+            s=$(run $bench $bin 2>> $log) || s=
+            if [ -z "$s" ]; then
+                status="run failed or invalid"
+                break
+            fi
+            echo "== run $i: $s" >> $log
+            scores="$scores $s"
+        done
+    fi
+
+    if [ -n "$status" ]; then
+        printf "%-10s %-8s %-20s %14s %8s %8s %10s  %s\n" \
+            $bench $cc $conf - - - - "$status"
+        echo "$bench,$cc,$conf,$(unit $bench),,,,,$status" >> $OUT/results.csv
+        return
+    fi
+
+    read median min max <<< $(printf "%s\n" $scores | sort -g | awk '
+        {v[NR] = $1}
+        END {print (NR % 2 ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2),
+             v[1], v[NR]}')
+    spread=$(awk -v m=$median -v lo=$min -v hi=$max \
+        'BEGIN {printf "%.1f", (m > 0 ? 100 * (hi - lo) / m : 0)}')
+    size=$(size $bin | awk 'NR == 2 {print $1}')
+
+    printf "%-10s %-8s %-20s %14.2f %8s %8s %10s  %s\n" \
+        $bench $cc $conf $median $(unit $bench) $spread% $size ok
+    echo "$bench,$cc,$conf,$(unit $bench),$median,$min,$max,$size,ok" >> $OUT/results.csv
+}
+
+mkdir -p $OUT
+echo "benchmark,compiler,config,unit,median,min,max,text_bytes,status" > $OUT/results.csv
+
+printf "%-10s %-8s %-20s %14s %8s %8s %10s  %s\n" \
+    Benchmark Compiler Config Median Unit Spread Text Status
+
+for cc in $COMPILERS; do
+    if ! command -v $cc > /dev/null; then
+        echo "$cc: not installed, skipped"
+        continue
+    fi
+    echo "$CONFIGS" | while read conf flags; do
+        [ -n "$conf" ] || continue
+        for bench in $BENCHMARKS; do
+            cell $cc $conf "$flags" $bench
+        done
+    done
+done
+
+echo "Results written to $OUT/results.csv, $REPS run(s) per cell"
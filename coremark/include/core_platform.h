@@ -16,6 +16,12 @@ ANSIbench platform-specific definitions for CoreMark
   #ifndef USE_CLOCK
   #define USE_CLOCK 0
   #endif
+/* - CLOCK_MONOTONIC_RAW is neither stepped nor slewed by NTP and has
+ *   nanosecond resolution, prefer it over the CLOCK_REALTIME sample timer
+ */
+  #ifndef USE_MONOTONIC_RAW
+  #define USE_MONOTONIC_RAW 1
+  #endif
 #endif
 
 /* AIX
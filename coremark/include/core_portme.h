@@ -45,6 +45,22 @@ Original Author: Shay Gal-on
 #ifndef USE_CLOCK
 #define USE_CLOCK 1
 #endif
+/* Configuration: USE_MONOTONIC_RAW
+	Define to 1 to time with clock_gettime(CLOCK_MONOTONIC_RAW) at nanosecond resolution.
+	This clock is not affected by NTP adjustments. Only takes effect if USE_CLOCK is 0.
+*/
+#ifndef USE_MONOTONIC_RAW
+#define USE_MONOTONIC_RAW 0
+#endif
+/* Configuration: USE_TSC
+	Define to 1 to time with the x86 time stamp counter.
+	The counter frequency is calibrated against CLOCK_MONOTONIC_RAW in <portable_init>,
+	and a warning is reported if the CPU does not advertise an invariant TSC.
+	Only takes effect if USE_CLOCK is 0, and takes precedence over USE_MONOTONIC_RAW.
+*/
+#ifndef USE_TSC
+#define USE_TSC 0
+#endif
 /* Configuration: HAS_STDIO
 	Define to 1 if the platform has stdio.h.
 */
@@ -66,6 +82,9 @@ Original Author: Shay Gal-on
 #if defined(_MSC_VER)
 #include <windows.h>
 typedef size_t CORE_TICKS;
+#elif !USE_CLOCK && (USE_TSC || USE_MONOTONIC_RAW)
+#include <time.h>
+typedef unsigned long long CORE_TICKS; /* nanoseconds or TSC cycles overflow 32b within seconds */
 #elif HAS_TIME_H
 #include <time.h>
 typedef clock_t CORE_TICKS;
@@ -145,6 +164,27 @@ typedef size_t ee_size_t;
 #define MEM_METHOD MEM_MALLOC
 #endif
 
+/* Constants: MEM_POLICY_*
+	Placement of the data blocks allocated by <portable_malloc> when MEM_METHOD is MEM_MALLOC.
+	Selected at run time with P<name> in <portable_init>, see <default_mem_policy>.
+	
+	Valid values:
+	MEM_POLICY_MALLOC - plain malloc (default).
+	MEM_POLICY_LINE - aligned to a 64 byte cache line.
+	MEM_POLICY_PAGE - aligned to a page.
+	MEM_POLICY_THP - 2MB aligned anonymous mapping advised for transparent hugepages.
+	MEM_POLICY_HUGETLB - explicit hugepages from the hugetlbfs pool (MAP_HUGETLB).
+	MEM_POLICY_LOCAL - page aligned, every page first touched by the pinned worker owning the context.
+	MEM_POLICY_INTERLEAVE - page aligned, pages interleaved over all allowed NUMA nodes.
+*/
+#define MEM_POLICY_MALLOC     0
+#define MEM_POLICY_LINE       1
+#define MEM_POLICY_PAGE       2
+#define MEM_POLICY_THP        3
+#define MEM_POLICY_HUGETLB    4
+#define MEM_POLICY_LOCAL      5
+#define MEM_POLICY_INTERLEAVE 6
+
 /* Configuration: MULTITHREAD
 	Define for parallel execution 
 	
@@ -155,7 +195,7 @@ typedef size_t ee_size_t;
 	Note: 
 	If this flag is defined to more then 1, an implementation for launching parallel contexts must be defined.
 	
-	Two sample implementations are provided. Use <USE_PTHREAD> or <USE_FORK> to enable them.
+	Sample implementations are provided. Use <USE_PTHREAD>, <USE_PTHREAD_POOL> or <USE_FORK> to enable them.
 	
 	It is valid to have a different implementation of <core_start_parallel> and <core_end_parallel> in <core_portme.c>,
 	to fit a particular architecture. 
@@ -184,9 +224,30 @@ typedef size_t ee_size_t;
 #include <pthread.h>
 #endif
 
+/* Configuration: USE_PTHREAD_POOL
+	Sample implementation for launching parallel contexts 
+	This implementation keeps a pool of persistent pthreads, each pinned to its own CPU.
+	Workers are released together through a start barrier and time their own context,
+	so thread creation and scheduler migration stay out of the measurement.
+	
+	Valid values:
+	0 - Do not use the thread pool.
+	1 - Use the thread pool (requires pthread_setaffinity_np, i.e. Linux/glibc).
+	
+	Note: 
+	This flag only matters if MULTITHREAD has been defined to a value greater then 1.
+*/
+#ifndef USE_PTHREAD_POOL
+#define USE_PTHREAD_POOL 0
+#elif (MULTITHREAD==1)
+#undef USE_PTHREAD_POOL
+#define USE_PTHREAD_POOL 0
+#endif
+
 /* Configuration: USE_FORK
 	Sample implementation for launching parallel contexts 
-	This implementation uses fork, waitpid, shmget,shmat and shmdt.
+	This implementation uses fork, waitpid and an anonymous shared mapping (mmap MAP_SHARED)
+	created before the fork, so concurrent runs on one host cannot collide on IPC keys.
 	
 	Valid values:
 	0 - Do not use fork API.
@@ -201,7 +262,8 @@ typedef size_t ee_size_t;
 
 /* Configuration: USE_SOCKET
 	Sample implementation for launching parallel contexts 
-	This implementation uses fork, socket, sendto and recvfrom
+	This implementation uses fork, socket, sendto and recvfrom.
+	The parent binds an ephemeral loopback UDP port for every context before the fork.
 	
 	Valid values:
 	0 - Do not use fork and sockets API.
@@ -247,15 +309,59 @@ typedef size_t ee_size_t;
 */
 extern ee_u32 default_num_contexts;
 
+/* Variable: default_sweep_contexts
+	If not 0, the benchmark is run once for every number of contexts from 1 up to this value,
+	and the scaling efficiency of each step is reported before the regular report of the last run.
+	
+	Note:
+	Set from the command line with S<n> in <portable_init>. S0 sweeps up to the number of online CPUs.
+	This value may not be set higher then the <MULTITHREAD> define.
+*/
+extern ee_u32 default_sweep_contexts;
+
+/* Variable: default_sweep_size
+	If not 0, the list, matrix and state kernels are each run alone on working sets of 2KB
+	doubling up to this many bytes, and Iterations/Sec of every size is reported before the regular run.
+	
+	Note:
+	Set from the command line with W<n> in <portable_init>, n takes a K or M suffix. W0 sweeps up to 64MB.
+	Only available with MEM_MALLOC.
+*/
+extern ee_u32 default_sweep_size;
+
+/* Variable: default_continuous_secs
+	If not 0, the benchmark runs until interrupted with SIGINT instead of once, and every
+	this many seconds reports the Iterations/Sec of the last interval, whether all CRCs so far
+	were correct and the current frequency of every CPU.
+	
+	Note:
+	Set from the command line with C<n> in <portable_init>. C0 reports every 10 secs.
+*/
+extern ee_u32 default_continuous_secs;
+
+/* Variable: default_mem_policy
+	Placement policy of the data blocks, one of the <MEM_POLICY_*> constants.
+	
+	Note:
+	Set from the command line with P<name> in <portable_init>, where name is one of
+	malloc, line, page, thp, hugetlb, local or interleave.
+	Policies that are not available fall back to a simpler one with a warning.
+*/
+extern ee_u32 default_mem_policy;
+
 #if (MULTITHREAD>1)
 #if USE_PTHREAD
 	#include <pthread.h>
 	#define PARALLEL_METHOD "PThreads"
+#elif USE_PTHREAD_POOL
+	#include <pthread.h>
+	#include <semaphore.h>
+	#define PARALLEL_METHOD "PThreadPool"
 #elif USE_FORK
 	#include <unistd.h>
 	#include <errno.h>
 	#include <sys/wait.h>
-	#include <sys/shm.h>
+	#include <sys/mman.h>
 	#include <string.h> /* for memcpy */
 	#define PARALLEL_METHOD "Fork"
 #elif USE_SOCKET
@@ -276,26 +382,56 @@ extern ee_u32 default_num_contexts;
 #endif /* Method for multithreading */
 #endif /* MULTITHREAD > 1 */
 
+#if CORE_KERNEL_PROFILE
+/* Define: NUM_COUNTERS
+	Counters read by <portable_counters_read>: ticks of <get_time_stamp>,
+	then CPU cycles, instructions and branch misses.
+*/
+#define NUM_COUNTERS 4
+typedef unsigned long long ee_counter;
+#endif
+
 typedef struct CORE_PORTABLE_S {
 #if (MULTITHREAD>1)
 	#if USE_PTHREAD
 	pthread_t thread;
+	#elif USE_PTHREAD_POOL
+	ee_u32 worker;     /* pool slot running this context */
+	ee_s32 cpu;        /* CPU the worker is pinned to, -1 if not pinned */
 	#elif USE_FORK
 	pid_t pid;
-	int shmid;
-	void *shm;
+	void *shm; /* core_results of the child, shared with the parent */
 	#elif USE_SOCKET
 	pid_t pid;
 	int sock;
 	struct sockaddr_in sa;
 	#endif /* Method for multithreading */
 #endif /* MULTITHREAD>1 */
+#if CORE_KERNEL_PROFILE
+	int counters_fd[NUM_COUNTERS-1]; /* CPU counters of the running context, -1 if not counting */
+#endif
 	ee_u8	portable_id;
 } core_portable;
 
 /* target specific init/fini */
 void portable_init(core_portable *p, int *argc, char *argv[]);
 void portable_fini(core_portable *p);
+/* report the timer in use, its resolution and any warning about it */
+void portable_timer_report(void);
+/* let the owner of context <ctx> touch its freshly allocated data block first */
+void portable_first_touch(void *p, ee_size_t size, ee_u32 ctx);
+/* report the placement policy of the data blocks */
+void portable_mem_report(void);
+/* true once the run should stop, on SIGINT in continuous mode */
+ee_u8 portable_stop_requested(void);
+/* print the current frequency of every CPU, if the platform exposes it */
+void portable_freq_report(void);
+#if CORE_KERNEL_PROFILE
+/* count the CPU of the calling thread, read the counters, stop counting */
+void portable_counters_open(core_portable *p);
+void portable_counters_read(core_portable *p, ee_counter *v);
+void portable_counters_close(core_portable *p);
+#endif
 
 #if (SEED_METHOD==SEED_VOLATILE)
  #if (VALIDATION_RUN || PERFORMANCE_RUN || PROFILE_RUN)
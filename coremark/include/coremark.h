@@ -27,6 +27,72 @@ Original Author: Shay Gal-on
 #define TOTAL_DATA_SIZE 2 * 1000
 #endif
 
+/* Configuration: CRC_METHOD
+        Define how the 16b CRC of the results is computed. All methods give
+   identical CRCs.
+
+        Valid values:
+        CRC_BITWISE - one bit at a time, the reference implementation (default).
+        CRC_TABLE - slice-by-8 lookup tables.
+        CRC_PCLMUL - as CRC_TABLE, plus carry-less multiply folding of bulk
+   buffers in <crcbuf>. Needs an x86 compiler targeting PCLMULQDQ (-mpclmul).
+*/
+#define CRC_BITWISE 0
+#define CRC_TABLE   1
+#define CRC_PCLMUL  2
+#ifndef CRC_METHOD
+#define CRC_METHOD CRC_BITWISE
+#endif
+
+/* Configuration: CORE_MATRIX_SIMD
+        Define to 1 to replace the matrix kernels with the SIMD versions in
+   core_matrix_simd.c. Used by the non-compliant simd target of the makefile.
+*/
+#ifndef CORE_MATRIX_SIMD
+#define CORE_MATRIX_SIMD 0
+#endif
+
+/* Configuration: CORE_LIST_INDEXED
+        Define to 1 to keep the list benchmark nodes in a contiguous array
+   ordered by an array of 16b indices, instead of a pointer linked list. The
+   list operations and the mergesort are done on the index array, with exactly
+   the same comparisons, so the CRCs are unchanged. For analysis of the cost of
+   pointer chasing only.
+*/
+#ifndef CORE_LIST_INDEXED
+#define CORE_LIST_INDEXED 0
+#endif
+
+/* Configuration: CORE_STATE_TABLE
+        Define to 1 to drive the state machine benchmark from a byte class
+   table and a state transition table, with a SIMD scan for the separators,
+   instead of the coded switch. The counts, and so the CRCs, are unchanged.
+   For analysis of branch costs only.
+*/
+#ifndef CORE_STATE_TABLE
+#define CORE_STATE_TABLE 0
+#endif
+
+/* Configuration: CORE_KERNEL_PROFILE
+        Define to 1 to attribute the run time, and the CPU cycles, instructions
+   and branch misses where the port can count them, to the list, matrix and
+   state kernels, reported per iteration after the score. Counters are read
+   every time <calc_func> enters or leaves a kernel, which adds to the run
+   time, so compare the score of such a build with other profiled builds only.
+*/
+#ifndef CORE_KERNEL_PROFILE
+#define CORE_KERNEL_PROFILE 0
+#endif
+
+/* Definition: CORE_COMPLIANT
+        1 if the build runs the reference implementation of every algorithm.
+   Options that replace it are for analysis only, and such a build does not
+   report a CoreMark score.
+*/
+#define CORE_COMPLIANT \
+    ((CRC_METHOD == CRC_BITWISE) && !CORE_MATRIX_SIMD && !CORE_LIST_INDEXED \
+     && !CORE_STATE_TABLE)
+
 #define SEED_ARG      0
 #define SEED_FUNC     1
 #define SEED_VOLATILE 2
@@ -69,12 +135,14 @@ void       start_time(void);
 void       stop_time(void);
 CORE_TICKS get_time(void);
 secs_ret   time_in_secs(CORE_TICKS ticks);
+CORE_TICKS get_time_stamp(void);
 
 /* Misc useful functions */
 ee_u16 crcu8(ee_u8 data, ee_u16 crc);
 ee_u16 crc16(ee_s16 newval, ee_u16 crc);
 ee_u16 crcu16(ee_u16 newval, ee_u16 crc);
 ee_u16 crcu32(ee_u32 newval, ee_u16 crc);
+ee_u16 crcbuf(const ee_u8 *buf, ee_u32 len, ee_u16 crc);
 ee_u8  check_data_types(void);
 void * portable_malloc(ee_size_t size);
 void   portable_free(void *p);
@@ -87,6 +155,14 @@ ee_s32 parseval(char *valstring);
 #define ALL_ALGORITHMS_MASK (ID_LIST | ID_MATRIX | ID_STATE)
 #define NUM_ALGORITHMS      3
 
+#if CORE_KERNEL_PROFILE
+/* Kernels the counters are charged to */
+#define KERNEL_LIST   0
+#define KERNEL_MATRIX 1
+#define KERNEL_STATE  2
+#define NUM_KERNELS   3
+#endif
+
 /* list data structures */
 typedef struct list_data_s
 {
@@ -94,11 +170,26 @@ typedef struct list_data_s
     ee_s16 idx;
 } list_data;
 
+#if CORE_LIST_INDEXED
+/* the nodes live in one array, the list order is an array of 16b indices */
+typedef struct list_head_s
+{
+    ee_u16 *            order; /* node indices in list order */
+    ee_u16 *            tmp;   /* scratch for the mergesort */
+    struct list_data_s *node;  /* node storage */
+    ee_u32              n;     /* nodes in the list, including the sentinels */
+} list_head;
+/* largest block the indexed list fills like the linked one, 16b indices
+   address at most 0x10000 nodes */
+#define LIST_INDEXED_MAX_BLOCK \
+    ((0x10000 + 3) * (16 + sizeof(struct list_data_s)))
+#else
 typedef struct list_head_s
 {
     struct list_head_s *next;
     struct list_data_s *info;
 } list_head;
+#endif
 
 /*matrix benchmark related stuff */
 #define MATDAT_INT 1
@@ -152,10 +243,21 @@ typedef struct RESULTS_S
     ee_u16 crcmatrix;
     ee_u16 crcstate;
     ee_s16 err;
+    CORE_TICKS start_stamp; /* <get_time_stamp> when this context started */
+    CORE_TICKS stop_stamp;  /* <get_time_stamp> when this context finished */
+#if CORE_KERNEL_PROFILE
+    ee_u8      kernel;                    /* kernel being charged */
+    ee_counter kernel_mark[NUM_COUNTERS]; /* counters at the last switch */
+    ee_counter kernel_count[NUM_KERNELS][NUM_COUNTERS]; /* charged so far */
+#endif
     /* ultithread specific */
     core_portable port;
 } core_results;
 
+#if CORE_KERNEL_PROFILE
+ee_u8 kernel_switch(core_results *res, ee_u8 kernel);
+#endif
+
 /* Multicore execution handling */
 #if (MULTITHREAD > 1)
 ee_u8 core_start_parallel(core_results *res);
@@ -181,6 +283,9 @@ ee_u32 core_init_matrix(ee_u32      blksize,
                         ee_s32      seed,
                         mat_params *p);
 ee_u16 core_bench_matrix(mat_params *p, ee_s16 seed, ee_u16 crc);
+#if CORE_MATRIX_SIMD
+extern const char *matrix_simd_isa;
+#endif
 
 /* seed argument handling (moved from core_main.c to resolve warnings) */
 #if (SEED_METHOD == SEED_ARG) 
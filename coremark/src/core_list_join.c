@@ -51,6 +51,7 @@ input for the operation.
 /* local functions */
 
 void copy_info(list_data *to, list_data *from);
+#if !CORE_LIST_INDEXED
 list_head *core_list_find(list_head *list, list_data *info);
 list_head *core_list_reverse(list_head *list);
 list_head *core_list_remove(list_head *item);
@@ -66,6 +67,9 @@ typedef ee_s32 (*list_cmp)(list_data *a, list_data *b, core_results *res);
 list_head *core_list_mergesort(list_head *   list,
                                list_cmp      cmp,
                                core_results *res);
+#else
+typedef ee_s32 (*list_cmp)(list_data *a, list_data *b, core_results *res);
+#endif
 
 /* function prototypes added to resolve strict compiler warnings */
 
@@ -89,23 +93,38 @@ calc_func(ee_s16 *pdata, core_results *res)
         ee_s16 dtype
             = ((data >> 3)
                & 0xf);       /* bits 3-6 is specific data for the operation */
+#if CORE_KERNEL_PROFILE
+        ee_u8 kernel; /* kernel charged by the caller */
+#endif
         dtype |= dtype << 4; /* replicate the lower 4 bits to get an 8b value */
         switch (flag)
         {
             case 0:
                 if (dtype < 0x22) /* set min period for bit corruption */
                     dtype = 0x22;
+#if CORE_KERNEL_PROFILE
+                kernel = kernel_switch(res, KERNEL_STATE);
+#endif
                 retval = core_bench_state(res->size,
                                           res->memblock[3],
                                           res->seed1,
                                           res->seed2,
                                           dtype,
                                           res->crc);
+#if CORE_KERNEL_PROFILE
+                kernel_switch(res, kernel);
+#endif
                 if (res->crcstate == 0)
                     res->crcstate = retval;
                 break;
             case 1:
+#if CORE_KERNEL_PROFILE
+                kernel = kernel_switch(res, KERNEL_MATRIX);
+#endif
                 retval = core_bench_matrix(&(res->mat), dtype, res->crc);
+#if CORE_KERNEL_PROFILE
+                kernel_switch(res, kernel);
+#endif
                 if (res->crcmatrix == 0)
                     res->crcmatrix = retval;
                 break;
@@ -155,6 +174,284 @@ copy_info(list_data *to, list_data *from)
     to->idx    = from->idx;
 }
 
+#if CORE_LIST_INDEXED
+/*
+Topic: Indexed list layout
+        With <CORE_LIST_INDEXED> the nodes are stored in one array and the list
+   order is an array of 16b node indices, list->order. Position 0 plays the
+   role of the list head pointer of the linked version.
+
+        Only the order of the data items matters to the benchmark, so every
+   linked list operation maps to an operation on the index array that leaves
+   the items in the same order: reversal reverses the array, moving an item
+   behind the head and removing the second item shift part of it, and the
+   mergesort is bottom-up over the array with the same runs and the same
+   comparisons as <core_list_mergesort>. Traversals are sequential over the
+   index array and prefetch the nodes ahead.
+*/
+#if defined(__GNUC__)
+#define list_prefetch(p) __builtin_prefetch(p)
+#else
+#define list_prefetch(p)
+#endif
+#define LIST_PREFETCH_AHEAD 8
+
+/* Function: list_item
+        Data of the item at position <pos> of the list.
+*/
+static list_data *
+list_item(list_head *list, ee_u32 pos)
+{
+    return &list->node[list->order[pos]];
+}
+
+/* Function: list_find
+        Position of the first item matching <info> (by idx if not negative, else
+   by data), or list->n if there is none.
+*/
+static ee_u32
+list_find(list_head *list, list_data *info)
+{
+    ee_u32 pos;
+    for (pos = 0; pos < list->n; pos++)
+    {
+        list_data *item;
+        if (pos + LIST_PREFETCH_AHEAD < list->n)
+            list_prefetch(list_item(list, pos + LIST_PREFETCH_AHEAD));
+        item = list_item(list, pos);
+        if ((info->idx >= 0) ? (item->idx == info->idx)
+                             : ((item->data16 & 0xff) == info->data16))
+            break;
+    }
+    return pos;
+}
+
+/* Function: list_reverse
+        Reverse the list.
+*/
+static void
+list_reverse(list_head *list)
+{
+    ee_u32 lo, hi;
+    for (lo = 0, hi = list->n - 1; lo < hi; lo++, hi--)
+    {
+        ee_u16 tmp      = list->order[lo];
+        list->order[lo] = list->order[hi];
+        list->order[hi] = tmp;
+    }
+}
+
+/* Function: list_move
+        Move the item at position <from> to position <to>, shifting the ones in
+   between.
+*/
+static void
+list_move(list_head *list, ee_u32 from, ee_u32 to)
+{
+    ee_u16 item = list->order[from];
+    for (; from > to; from--)
+        list->order[from] = list->order[from - 1];
+    for (; from < to; from++)
+        list->order[from] = list->order[from + 1];
+    list->order[to] = item;
+}
+
+/* Function: list_mergesort
+        Sort the list, stable, without recursion.
+
+        Runs of insize items starting at the head are merged pairwise into
+   list->tmp, taking from the first run while cmp is not positive, and the
+   index arrays are swapped after every pass. This compares exactly the same
+   items in the same order as the linked <core_list_mergesort>, which matters
+   because cmp_complex has side effects.
+*/
+static void
+list_mergesort(list_head *list, list_cmp cmp, core_results *res)
+{
+    ee_u32 insize, start, n = list->n;
+    for (insize = 1; insize < n; insize *= 2)
+    {
+        ee_u16 *src = list->order, *dst = list->tmp;
+        for (start = 0; start < n; start += 2 * insize)
+        {
+            ee_u32 p = start, pend = start + insize, q, qend, out = start;
+            if (pend > n)
+                pend = n;
+            q    = pend;
+            qend = (q + insize > n) ? n : q + insize;
+            while ((p < pend) || (q < qend))
+            {
+                if (p == pend)
+                    dst[out++] = src[q++];
+                else if (q == qend)
+                    dst[out++] = src[p++];
+                else if (cmp(&list->node[src[p]], &list->node[src[q]], res)
+                         <= 0)
+                    dst[out++] = src[p++];
+                else
+                    dst[out++] = src[q++];
+            }
+        }
+        list->order = dst;
+        list->tmp   = src;
+    }
+}
+
+/* Benchmark for the indexed list, see <Indexed list layout>:
+        Same steps and same result as the linked version below.
+*/
+ee_u16
+core_bench_list(core_results *res, ee_s16 finder_idx)
+{
+    ee_u16     retval = 0;
+    ee_u16     found = 0, missed = 0;
+    list_head *list     = res->list;
+    ee_s16     find_num = res->seed3;
+    ee_u32     this_find, finder;
+    ee_u16     remover;
+    list_data  info = {0};
+    ee_s16     i;
+
+    info.idx = finder_idx;
+    /* find <find_num> values in the list, and change the list each time
+     * (reverse and cache if value found) */
+    for (i = 0; i < find_num; i++)
+    {
+        info.data16 = (i & 0xff);
+        this_find   = list_find(list, &info);
+        list_reverse(list);
+        if (this_find == list->n)
+        {
+            missed++;
+            retval += (list_item(list, 1)->data16 >> 8) & 1;
+        }
+        else
+        {
+            /* after the reversal the found item is here */
+            this_find = list->n - 1 - this_find;
+            found++;
+            if (list_item(list, this_find)->data16 & 0x1) /* use found value */
+                retval += (list_item(list, this_find)->data16 >> 9) & 1;
+            /* and cache next item at the head of the list (if any) */
+            if (this_find + 1 < list->n)
+                list_move(list, this_find + 1, 1);
+        }
+        if (info.idx >= 0)
+            info.idx++;
+#if CORE_DEBUG
+        ee_printf("List find %d: [%d,%d,%d]\n", i, retval, missed, found);
+#endif
+    }
+    retval += found * 4 - missed;
+    /* sort the list by data content and remove one item*/
+    if (finder_idx > 0)
+        list_mergesort(list, cmp_complex, res);
+    remover = list->order[1];
+    list_move(list, 1, list->n - 1);
+    list->n--;
+    /* CRC data content of list from location of index N forward, and then undo
+     * remove */
+    finder = list_find(list, &info);
+    if (finder == list->n)
+        finder = 1;
+    for (; finder < list->n; finder++)
+        retval = crc16(list_item(list, 0)->data16, retval);
+#if CORE_DEBUG
+    ee_printf("List sort 1: %04x\n", retval);
+#endif
+    list->order[list->n++] = remover;
+    list_move(list, list->n - 1, 1);
+    /* sort the list by index, in effect returning the list to original state */
+    list_mergesort(list, cmp_idx, NULL);
+    /* CRC data content of list */
+    for (finder = 1; finder < list->n; finder++)
+        retval = crc16(list_item(list, 0)->data16, retval);
+#if CORE_DEBUG
+    ee_printf("List sort 2: %04x\n", retval);
+#endif
+    return retval;
+}
+
+/* Function: core_list_init
+        Initialize the indexed list with the same items, in the same order, as
+   the linked version.
+
+        Parameters:
+        blksize - Size of memory to be initialized.
+        memblock - Pointer to memory block.
+        seed - 	Actual values chosen depend on the seed parameter.
+                The seed parameter MUST be supplied from a source that cannot be
+   determined at compile time
+
+        Returns:
+        Pointer to the list, at the start of the memory block.
+*/
+list_head *
+core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed)
+{
+    /* same number of items as the linked version, which inserts a head, a
+       tail and size-3 items into room for size */
+    ee_u32     per_item = 16 + sizeof(struct list_data_s);
+    ee_u32     size     = (blksize / per_item) - 2;
+    list_head *list     = memblock;
+    ee_u32     i, pos;
+
+    list->n = size - 1;
+    if (list->n > 0x10000)
+    { /* the list is shorter than the linked one, so are the results */
+        ee_printf("ERROR! Indexed list holds at most 65536 items, not %lu\n",
+                  (long unsigned)list->n);
+        list->n = 0x10000;
+        size    = list->n + 1;
+    }
+    list->node  = (list_data *)(list + 1);
+    list->order = (ee_u16 *)(list->node + list->n);
+    list->tmp   = list->order + list->n;
+
+    /* fake items for the list head and tail, and the items in between in the
+       order the linked version inserts them */
+    list->node[0].idx            = 0x0000;
+    list->node[0].data16         = (ee_s16)0x8080;
+    list->node[list->n - 1].idx    = 0x7fff;
+    list->node[list->n - 1].data16 = (ee_s16)0xffff;
+    for (i = 0; i + 3 < size; i++)
+    {
+        ee_u16 datpat = ((ee_u16)(seed ^ i) & 0xf);
+        ee_u16 dat
+            = (datpat << 3) | (i & 0x7); /* alternate between algorithms */
+        pos = list->n - 2 - i;           /* every item goes in behind the head */
+        list->node[pos].data16 = (dat << 8) | dat;
+        list->node[pos].idx    = 0;
+    }
+    for (pos = 0; pos < list->n; pos++)
+        list->order[pos] = pos;
+    /* and now index the list so we know initial seed order of the list */
+    i = 1;
+    for (pos = 1; pos + 1 < list->n; pos++)
+    {
+        if (i < size / 5) /* first 20% of the list in order */
+            list->node[pos].idx = i++;
+        else
+        {
+            ee_u16 pat = (ee_u16)(i++ ^ seed); /* get a pseudo random number */
+            list->node[pos].idx = 0x3fff
+                                  & (((i & 0x07) << 8)
+                                     | pat); /* make sure the mixed items end
+                                                up after the ones in sequence */
+        }
+    }
+    list_mergesort(list, cmp_idx, NULL);
+#if CORE_DEBUG
+    ee_printf("Initialized list:\n");
+    for (pos = 0; pos < list->n; pos++)
+        ee_printf("[%04x,%04x]",
+                  list_item(list, pos)->idx,
+                  (ee_u16)list_item(list, pos)->data16);
+    ee_printf("\n");
+#endif
+    return list;
+}
+#else /* linked list */
 /* Benchmark for linked list:
         - Try to find multiple data items.
         - List sort
@@ -600,3 +897,4 @@ core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
     return list;
 #endif
 }
+#endif /* CORE_LIST_INDEXED */
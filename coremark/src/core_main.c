@@ -48,6 +48,31 @@ static ee_u16 state_known_crc[]  = { (ee_u16)0x5e47,
                                     (ee_u16)0xe5a4,
                                     (ee_u16)0x8e3a,
                                     (ee_u16)0x8d84 };
+#if CORE_KERNEL_PROFILE
+/* Function: kernel_switch
+        Charge the counters since the last switch to the kernel charged so far,
+   and charge <kernel> from now on.
+
+        Returns:
+        The kernel charged so far, to switch back to.
+*/
+ee_u8
+kernel_switch(core_results *res, ee_u8 kernel)
+{
+    ee_counter now[NUM_COUNTERS];
+    ee_u8      prev = res->kernel;
+    ee_u32     i;
+    portable_counters_read(&(res->port), now);
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        res->kernel_count[prev][i] += now[i] - res->kernel_mark[i];
+        res->kernel_mark[i] = now[i];
+    }
+    res->kernel = kernel;
+    return prev;
+}
+#endif
+
 void *
 iterate(void *pres)
 {
@@ -59,19 +84,555 @@ iterate(void *pres)
     res->crclist             = 0;
     res->crcmatrix           = 0;
     res->crcstate            = 0;
+    res->start_stamp         = get_time_stamp();
+#if CORE_KERNEL_PROFILE
+    /* counters are per thread, open them in the one running this context */
+    for (i = 0; i < NUM_KERNELS * NUM_COUNTERS; i++)
+        res->kernel_count[i / NUM_COUNTERS][i % NUM_COUNTERS] = 0;
+    portable_counters_open(&(res->port));
+    portable_counters_read(&(res->port), res->kernel_mark);
+    res->kernel = KERNEL_LIST;
+#endif
 
-    for (i = 0; i < iterations; i++)
+    if (res->execs & ID_LIST)
     {
-        crc      = core_bench_list(res, 1);
-        res->crc = crcu16(crc, res->crc);
-        crc      = core_bench_list(res, -1);
-        res->crc = crcu16(crc, res->crc);
-        if (i == 0)
-            res->crclist = res->crc;
+        for (i = 0; i < iterations; i++)
+        {
+            crc      = core_bench_list(res, 1);
+            res->crc = crcu16(crc, res->crc);
+            crc      = core_bench_list(res, -1);
+            res->crc = crcu16(crc, res->crc);
+            if (i == 0)
+                res->crclist = res->crc;
+        }
+    }
+    else
+    { /* no list to drive the other kernels, call them once per iteration */
+        ee_s16 step = (res->seed3 < 0x22) ? 0x22 : res->seed3;
+        for (i = 0; i < iterations; i++)
+        {
+            if (res->execs & ID_MATRIX)
+            {
+#if CORE_KERNEL_PROFILE
+                kernel_switch(res, KERNEL_MATRIX);
+#endif
+                crc      = core_bench_matrix(&(res->mat), res->seed3, res->crc);
+                res->crc = crcu16(crc, res->crc);
+                if (i == 0)
+                    res->crcmatrix = crc;
+            }
+            if (res->execs & ID_STATE)
+            {
+#if CORE_KERNEL_PROFILE
+                kernel_switch(res, KERNEL_STATE);
+#endif
+                crc      = core_bench_state(res->size,
+                                       res->memblock[3],
+                                       res->seed1,
+                                       res->seed2,
+                                       step,
+                                       res->crc);
+                res->crc = crcu16(crc, res->crc);
+                if (i == 0)
+                    res->crcstate = crc;
+            }
+        }
     }
+#if CORE_KERNEL_PROFILE
+    kernel_switch(res, KERNEL_LIST);
+    portable_counters_close(&(res->port));
+#endif
+    res->stop_stamp = get_time_stamp();
     return NULL;
 }
 
+/* Variable: run_errors
+        Contexts <run_contexts> could not start. They have no results to
+   check, so they fail the run whatever the seeds.
+*/
+static ee_s16 run_errors = 0;
+
+/* Function: run_contexts
+        Run and time <n> contexts, each executing the iterations set in the
+   first context.
+
+        Returns:
+        Ticks for the whole run, from launching the first context to
+   gathering the last one.
+*/
+static CORE_TICKS
+run_contexts(core_results *results, ee_u32 n)
+{
+    start_time();
+#if (MULTITHREAD > 1)
+    ee_u32 i, started;
+    default_num_contexts = n;
+    for (started = 0; started < n; started++)
+    {
+        results[started].iterations = results[0].iterations;
+        results[started].execs      = results[0].execs;
+        if (!core_start_parallel(&results[started]))
+        {
+            ee_printf("ERROR! Could not start context %u of %u\n", started, n);
+            run_errors += n - started;
+            break;
+        }
+    }
+    for (i = 0; i < started; i++)
+    {
+        core_stop_parallel(&results[i]);
+    }
+#else
+    (void)n;
+    iterate(&results[0]);
+#endif
+    stop_time();
+    return get_time();
+}
+
+#if (MULTITHREAD > 1) && HAS_FLOAT
+/* Function: context_ips
+        Iterations per second of a single context, from its own time stamps.
+*/
+static secs_ret
+context_ips(core_results *res)
+{
+    secs_ret secs = time_in_secs(res->stop_stamp - res->start_stamp);
+    return (secs > 0) ? res->iterations / secs : 0;
+}
+
+/* Function: context_extremes
+        Find the slowest and the fastest of <n> contexts.
+*/
+static void
+context_extremes(core_results *results, ee_u32 n, ee_u32 *slow, ee_u32 *fast)
+{
+    ee_u32 i;
+    *slow = *fast = 0;
+    for (i = 1; i < n; i++)
+    {
+        if (context_ips(&results[i]) < context_ips(&results[*slow]))
+            *slow = i;
+        if (context_ips(&results[i]) > context_ips(&results[*fast]))
+            *fast = i;
+    }
+}
+#endif
+
+#if CORE_KERNEL_PROFILE && HAS_FLOAT
+/* Function: kernel_report
+        Print the time and CPU counters charged to every kernel, per iteration
+   and averaged over <n> contexts.
+*/
+static void
+kernel_report(core_results *results, ee_u32 n)
+{
+    static const char *kernel_name[NUM_KERNELS] = { "list", "matrix", "state" };
+    ee_counter         sum[NUM_KERNELS][NUM_COUNTERS], ticks = 0, cpu = 0;
+    secs_ret           iterations = (secs_ret)n * results[0].iterations;
+    ee_u32             i, k, c;
+    for (k = 0; k < NUM_KERNELS; k++)
+        for (c = 0; c < NUM_COUNTERS; c++)
+        {
+            sum[k][c] = 0;
+            for (i = 0; i < n; i++)
+                sum[k][c] += results[i].kernel_count[k][c];
+            if (c == 0)
+                ticks += sum[k][c];
+            else
+                cpu += sum[k][c];
+        }
+    if ((ticks == 0) || (iterations == 0))
+        return;
+    ee_printf("Kernel profile   : per iteration, %u context(s)%s\n",
+              n,
+              cpu ? "" : ", CPU counters not available");
+    ee_printf("Kernel        usecs  Share");
+    if (cpu)
+        ee_printf("      Cycles  Instructions   IPC  Branch-misses");
+    ee_printf("\n");
+    for (k = 0; k < NUM_KERNELS; k++)
+    {
+        ee_printf("%-8s %10.3f %5.1f%%",
+                  kernel_name[k],
+                  time_in_secs(sum[k][0]) * 1e6 / iterations,
+                  100.0 * sum[k][0] / ticks);
+        if (cpu)
+            ee_printf(" %11.0f %13.0f %5.2f %14.1f",
+                      sum[k][1] / iterations,
+                      sum[k][2] / iterations,
+                      sum[k][1] ? (secs_ret)sum[k][2] / sum[k][1] : 0,
+                      sum[k][3] / iterations);
+        ee_printf("\n");
+    }
+}
+#endif
+
+/* Function: known_crc_check
+        Compare the CRCs of the first <n> contexts with the known output of
+   the common seeds, identified by <seedcrc>, and check the data types.
+
+        Returns:
+        Number of errors, with <known_id> set to the matching seeds, or -1
+   plus the data type errors if the seeds are not known.
+*/
+static ee_s16
+known_crc_check(core_results *results, ee_u32 n, ee_u16 seedcrc, ee_s16 *known_id)
+{
+    ee_s16 errors = 0;
+    ee_u32 i;
+
+    *known_id = -1;
+    switch (seedcrc)
+    {                /* test known output for common seeds */
+        case 0x8a02: /* seed1=0, seed2=0, seed3=0x66, size 2000 per algorithm */
+            *known_id = 0;
+            ee_printf("6k performance run parameters for coremark.\n");
+            break;
+        case 0x7b05: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 2000 per
+                        algorithm */
+            *known_id = 1;
+            ee_printf("6k validation run parameters for coremark.\n");
+            break;
+        case 0x4eaf: /* seed1=0x8, seed2=0x8, seed3=0x8, size 400 per algorithm
+                      */
+            *known_id = 2;
+            ee_printf("Profile generation run parameters for coremark.\n");
+            break;
+        case 0xe9f5: /* seed1=0, seed2=0, seed3=0x66, size 666 per algorithm */
+            *known_id = 3;
+            ee_printf("2K performance run parameters for coremark.\n");
+            break;
+        case 0x18f2: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 666 per
+                        algorithm */
+            *known_id = 4;
+            ee_printf("2K validation run parameters for coremark.\n");
+            break;
+        default:
+            errors = -1;
+            break;
+    }
+    if (*known_id >= 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            results[i].err = 0;
+            if ((results[i].execs & ID_LIST)
+                && (results[i].crclist != list_known_crc[*known_id]))
+            {
+                ee_printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n",
+                          i,
+                          results[i].crclist,
+                          list_known_crc[*known_id]);
+                results[i].err++;
+            }
+            if ((results[i].execs & ID_MATRIX)
+                && (results[i].crcmatrix != matrix_known_crc[*known_id]))
+            {
+                ee_printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n",
+                          i,
+                          results[i].crcmatrix,
+                          matrix_known_crc[*known_id]);
+                results[i].err++;
+            }
+            if ((results[i].execs & ID_STATE)
+                && (results[i].crcstate != state_known_crc[*known_id]))
+            {
+                ee_printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n",
+                          i,
+                          results[i].crcstate,
+                          state_known_crc[*known_id]);
+                results[i].err++;
+            }
+            errors += results[i].err;
+        }
+    }
+    errors += check_data_types();
+    return errors;
+}
+
+/* Function: seed_crc
+        A function of the input, to recognize the common seeds.
+*/
+static ee_u16
+seed_crc(core_results *results)
+{
+    ee_u16 seedcrc = 0;
+    seedcrc        = crc16(results[0].seed1, seedcrc);
+    seedcrc        = crc16(results[0].seed2, seedcrc);
+    seedcrc        = crc16(results[0].seed3, seedcrc);
+    return crc16(results[0].size, seedcrc);
+}
+
+#if HAS_FLOAT
+/* Configuration: CONTINUOUS_CHUNK_SECS
+        Approximate run time of the iterations run between two checks for
+   SIGINT and the end of an interval in continuous mode.
+*/
+#ifndef CONTINUOUS_CHUNK_SECS
+#define CONTINUOUS_CHUNK_SECS 0.1
+#endif
+
+/* Function: continuous_run
+        Run the contexts until <portable_stop_requested>, and every <interval>
+   secs report the Iterations/Sec of that interval, the CRC errors so far and
+   the CPU frequencies. Used for burn-ins, to watch throttling and turbo decay.
+
+        Operation:
+        The iterations are run in chunks of about <CONTINUOUS_CHUNK_SECS>
+   secs. The CRCs of the first chunk of the first context are the reference
+   every context must reproduce in every chunk, so a wrong result at any
+   point of the run is caught. The first chunk of every context is also
+   checked against the known output of the common seeds, as in a normal run.
+   The interval cut short by SIGINT counts in the totals, but not in the
+   interval range.
+
+        Returns:
+        Number of errors: chunks with a CRC mismatch and known CRC errors of
+   the first chunk, or -1 if there are none but the seeds are not known.
+*/
+static ee_s16
+continuous_run(core_results *results, ee_u32 n, ee_u32 interval)
+{
+    core_results ref;
+    CORE_TICKS   run_start, interval_start, ticks = 0, now;
+    secs_ret     iterations = 0, total = 0, ips = 0, first = 0, last = 0;
+    secs_ret     low = 0, high = 0;
+    ee_u32       chunks = 0, errors = 0, i;
+    ee_s16       known_id, known_errors;
+
+    results[0].iterations = 1;
+    while ((time_in_secs(run_contexts(results, n)) < CONTINUOUS_CHUNK_SECS)
+           && !portable_stop_requested() && (run_errors == 0))
+        results[0].iterations *= 2;
+    ref = results[0];
+    ee_printf("Continuous run   : %u context(s), %lu iterations per chunk, "
+              "report every %u secs, stop with Ctrl-C\n",
+              n,
+              (long unsigned)results[0].iterations,
+              interval);
+    ee_printf("Reference CRCs   : list 0x%04x matrix 0x%04x state 0x%04x "
+              "final 0x%04x\n",
+              ref.crclist,
+              ref.crcmatrix,
+              ref.crcstate,
+              ref.crc);
+    known_errors = known_crc_check(results, n, seed_crc(results), &known_id);
+    ee_printf("    Secs  Iterations/Sec  CRC\n");
+    run_start = interval_start = get_time_stamp();
+    while (!portable_stop_requested() && (run_errors == 0))
+    {
+        ticks += run_contexts(results, n);
+        iterations += (secs_ret)n * results[0].iterations;
+        for (i = 0; i < n; i++)
+            if ((results[i].crc != ref.crc) || (results[i].crclist != ref.crclist)
+                || (results[i].crcmatrix != ref.crcmatrix)
+                || (results[i].crcstate != ref.crcstate))
+            {
+                ee_printf("[%u]ERROR! crc 0x%04x - should be 0x%04x\n",
+                          i,
+                          results[i].crc,
+                          ref.crc);
+                errors++;
+                break;
+            }
+        chunks++;
+        now = get_time_stamp();
+        if ((time_in_secs(now - interval_start) < interval)
+            && !portable_stop_requested())
+            continue;
+        /* end of an interval, or of a partial one on SIGINT */
+        ips = (time_in_secs(ticks) > 0) ? iterations / time_in_secs(ticks) : 0;
+        total += iterations;
+        if (time_in_secs(now - interval_start) >= interval)
+        {
+            if (first == 0)
+                first = low = high = ips;
+            if (ips < low)
+                low = ips;
+            if (ips > high)
+                high = ips;
+            last = ips;
+        }
+        ee_printf("%8.1f %15.3f  %s%s",
+                  time_in_secs(now - run_start),
+                  ips,
+                  (errors || (known_errors > 0)) ? "FAIL" : "ok",
+                  (time_in_secs(now - interval_start) < interval) ? " (partial)"
+                                                                  : "");
+        portable_freq_report();
+        ee_printf("\n");
+        interval_start = now;
+        ticks          = 0;
+        iterations     = 0;
+    }
+    if (total > 0)
+    {
+        now = get_time_stamp();
+        ee_printf("Total time (secs): %f\n", time_in_secs(now - run_start));
+        ee_printf("Iterations       : %.0f\n", total);
+        ee_printf("Iterations/Sec   : %f\n",
+                  total / time_in_secs(now - run_start));
+    }
+    if (first > 0)
+        ee_printf("Interval range   : %f - %f Iter/Sec, last interval "
+                  "%.1f%% of the first\n",
+                  low,
+                  high,
+                  100.0 * last / first);
+    ee_printf("CRC errors       : %u of %u chunks\n", errors, chunks);
+    errors += run_errors;
+    if (known_errors > 0)
+        errors += known_errors;
+    if ((errors == 0) && (known_errors < 0))
+        return -1;
+    return (ee_s16)(errors > 0x7fff ? 0x7fff : errors);
+}
+#endif
+
+#if (MEM_METHOD == MEM_MALLOC) && HAS_FLOAT
+/* Configuration: SWEEP_SECS
+        Approximate run time of every kernel and size of the working set sweep.
+*/
+#ifndef SWEEP_SECS
+#define SWEEP_SECS 1
+#endif
+
+/* Function: sweep_init
+        Initialize the data of the kernels selected in res->execs. The list
+   takes <size> bytes, the matrix and state blocks res->size bytes.
+*/
+static void
+sweep_init(core_results *res, ee_u32 size)
+{
+    if (res->execs & ID_LIST)
+        res->list = core_list_init(size, res->memblock[1], res->seed1);
+    if (res->execs & ID_MATRIX)
+        core_init_matrix(res->size,
+                         res->memblock[2],
+                         (ee_s32)res->seed1 | (((ee_s32)res->seed2) << 16),
+                         &(res->mat));
+    if (res->execs & ID_STATE)
+        core_init_state(res->size, res->seed1, res->memblock[3]);
+}
+
+/* Function: sweep_crc
+        CRC of the first iteration of the kernel selected in res->execs.
+*/
+static ee_u16
+sweep_crc(core_results *res)
+{
+    if (res->execs & ID_LIST)
+        return res->crclist;
+    if (res->execs & ID_MATRIX)
+        return res->crcmatrix;
+    return res->crcstate;
+}
+
+/* Function: working_set_sweep
+        Run the list, matrix and state kernels alone on working sets of 2KB
+   doubling up to <max_size>, and report Iterations/Sec for every size.
+
+        Operation:
+        The list kernel runs the matrix and state kernels from calc_func, as
+   in the benchmark, so its contexts also get matrix and state data of the
+   default size after the list. Only the list follows the working set.
+
+        There are no known CRCs for these sizes, so for every size and kernel
+   one iteration on freshly initialized data gives the reference CRC. It also
+   sets the number of iterations for about <SWEEP_SECS> secs. The data is then
+   initialized again for every context, and each context must reproduce the
+   reference CRC in its timed run.
+
+        Returns:
+        Number of CRC mismatches.
+*/
+static ee_s16
+working_set_sweep(core_results *results, ee_u32 max_size)
+{
+    core_results sweep[MULTITHREAD];
+    ee_u32       size, k, ctx, n = 1;
+    ee_s16       errors = 0;
+#if (MULTITHREAD > 1)
+    n = default_num_contexts;
+#endif
+    ee_printf("Working set sweep, %u context(s), Iterations/Sec of all "
+              "contexts\n",
+              n);
+    ee_printf("Size(KB)  List Iter/Sec crclist  Matrix Iter/Sec crcmatrix  "
+              "State Iter/Sec crcstate\n");
+    for (size = 2048; size <= max_size; size *= 2)
+    {
+        ee_printf("%8lu", (long unsigned)size / 1024);
+        for (k = 0; k < NUM_ALGORITHMS; k++)
+        {
+            secs_ret secs;
+            ee_u16   ref;
+            ee_u32   extra = (k == 0) ? 2 * results[0].size : 0;
+#if CORE_LIST_INDEXED
+            if ((k == 0) && (size > LIST_INDEXED_MAX_BLOCK))
+            { /* the list would be cut short, see <core_list_init> */
+                ee_printf(" %14s %6s ", "-", "-");
+                continue;
+            }
+#endif
+            for (ctx = 0; ctx < n; ctx++)
+            {
+                ee_u8 *block = (ee_u8 *)portable_malloc(size + extra);
+                portable_first_touch(block, size + extra, ctx);
+                sweep[ctx]             = results[0];
+                sweep[ctx].memblock[0] = block;
+                if (k == 0)
+                {
+                    sweep[ctx].execs       = ALL_ALGORITHMS_MASK;
+                    sweep[ctx].memblock[1] = block;
+                    sweep[ctx].memblock[2] = block + size;
+                    sweep[ctx].memblock[3] = block + size + results[0].size;
+                }
+                else
+                {
+                    sweep[ctx].execs           = 1 << k;
+                    sweep[ctx].size            = size;
+                    sweep[ctx].memblock[k + 1] = block;
+                }
+            }
+            /* reference run */
+            sweep[0].iterations = 1;
+            sweep_init(&sweep[0], size);
+            secs = time_in_secs(run_contexts(sweep, 1));
+            ref  = sweep_crc(&sweep[0]);
+            sweep[0].iterations
+                = (secs < SWEEP_SECS) ? (ee_u32)(SWEEP_SECS / secs) : 1;
+            /* timed run */
+            for (ctx = 0; ctx < n; ctx++)
+                sweep_init(&sweep[ctx], size);
+            secs = time_in_secs(run_contexts(sweep, n));
+            ee_printf(k == 1 ? " %16.3f 0x%04x   " : " %14.3f 0x%04x ",
+                      n * sweep[0].iterations / secs,
+                      ref);
+            for (ctx = 0; ctx < n; ctx++)
+            {
+                if (sweep_crc(&sweep[ctx]) != ref)
+                {
+                    ee_printf("\n[%u]ERROR! %s crc 0x%04x - should be 0x%04x",
+                              ctx,
+                              k == 0 ? "list" : (k == 1 ? "matrix" : "state"),
+                              sweep_crc(&sweep[ctx]),
+                              ref);
+                    errors++;
+                }
+                portable_free(sweep[ctx].memblock[0]);
+            }
+        }
+        ee_printf("\n");
+    }
+#if (MULTITHREAD > 1)
+    default_num_contexts = n;
+#endif
+    return errors;
+}
+#endif
+
 #if (MEM_METHOD == MEM_STATIC)
 ee_u8 static_memblk[TOTAL_DATA_SIZE];
 #endif
@@ -107,9 +668,10 @@ main(int argc, char *argv[])
 {
 #endif
     ee_u16       i, j = 0, num_algorithms = 0;
-    ee_s16       known_id = -1, total_errors = 0;
+    ee_s16       known_id = -1, total_errors = 0, errors;
+    ee_s16       sweep_errors = 0;
     ee_u16       seedcrc = 0;
-    CORE_TICKS   total_time;
+    CORE_TICKS   total_time = 0;
     core_results results[MULTITHREAD];
 #if (MEM_METHOD == MEM_STACK)
     ee_u8 stack_memblock[TOTAL_DATA_SIZE * MULTITHREAD];
@@ -165,6 +727,7 @@ main(int argc, char *argv[])
         else
             results[i].size = TOTAL_DATA_SIZE;
         results[i].memblock[0] = portable_malloc(results[i].size);
+        portable_first_touch(results[i].memblock[0], results[i].size, i);
         results[i].seed1       = results[0].seed1;
         results[i].seed2       = results[0].seed2;
         results[i].seed3       = results[0].seed3;
@@ -229,6 +792,27 @@ for (i = 0; i < MULTITHREAD; i++)
         }
     }
 
+#if HAS_FLOAT
+    if (default_continuous_secs > 0)
+    { /* reports as it goes until interrupted, instead of once */
+        total_errors
+            = continuous_run(results, default_num_contexts, default_continuous_secs);
+        ee_printf("Memory location  : %s\n", MEM_LOCATION);
+        if (total_errors == 0)
+            ee_printf("Correct operation validated.\n");
+        if (total_errors > 0)
+            ee_printf("Errors detected\n");
+        if (total_errors < 0)
+            ee_printf("Cannot validate operation for these seed values, "
+                      "please compare with results on a known platform.\n");
+#if (MEM_METHOD == MEM_MALLOC)
+        for (i = 0; i < MULTITHREAD; i++)
+            portable_free(results[i].memblock[0]);
+#endif
+        portable_fini(&(results[0].port));
+        return MAIN_RETURN_VAL;
+    }
+#endif
     /* automatically determine number of iterations if not set */
     if (results[0].iterations == 0)
     {
@@ -253,98 +837,72 @@ for (i = 0; i < MULTITHREAD; i++)
         results[0].iterations *= 1 + 10 / divisor;
     }
     /* perform actual benchmark */
-    start_time();
 #if (MULTITHREAD > 1)
     if (default_num_contexts > MULTITHREAD)
     {
         default_num_contexts = MULTITHREAD;
     }
-    for (i = 0; i < default_num_contexts; i++)
-    {
-        results[i].iterations = results[0].iterations;
-        results[i].execs      = results[0].execs;
-        core_start_parallel(&results[i]);
-    }
-    for (i = 0; i < default_num_contexts; i++)
-    {
-        core_stop_parallel(&results[i]);
-    }
-#else
-    iterate(&results[0]);
 #endif
-    stop_time();
-    total_time = get_time();
-    /* get a function of the input to report */
-    seedcrc = crc16(results[0].seed1, seedcrc);
-    seedcrc = crc16(results[0].seed2, seedcrc);
-    seedcrc = crc16(results[0].seed3, seedcrc);
-    seedcrc = crc16(results[0].size, seedcrc);
-
-    switch (seedcrc)
-    {                /* test known output for common seeds */
-        case 0x8a02: /* seed1=0, seed2=0, seed3=0x66, size 2000 per algorithm */
-            known_id = 0;
-            ee_printf("6k performance run parameters for coremark.\n");
-            break;
-        case 0x7b05: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 2000 per
-                        algorithm */
-            known_id = 1;
-            ee_printf("6k validation run parameters for coremark.\n");
-            break;
-        case 0x4eaf: /* seed1=0x8, seed2=0x8, seed3=0x8, size 400 per algorithm
-                      */
-            known_id = 2;
-            ee_printf("Profile generation run parameters for coremark.\n");
-            break;
-        case 0xe9f5: /* seed1=0, seed2=0, seed3=0x66, size 666 per algorithm */
-            known_id = 3;
-            ee_printf("2K performance run parameters for coremark.\n");
-            break;
-        case 0x18f2: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 666 per
-                        algorithm */
-            known_id = 4;
-            ee_printf("2K validation run parameters for coremark.\n");
-            break;
-        default:
-            total_errors = -1;
-            break;
-    }
-    if (known_id >= 0)
-    {
-        for (i = 0; i < default_num_contexts; i++)
+#if (MEM_METHOD == MEM_MALLOC) && HAS_FLOAT
+    if (default_sweep_size > 0)
+        sweep_errors += working_set_sweep(results, default_sweep_size);
+#endif
+#if (MULTITHREAD > 1)
+#if HAS_FLOAT
+    if (default_sweep_contexts > 0)
+    { /* scaling sweep, every step runs the same iterations per context */
+        secs_ret ips_one = 0;
+        ee_u32   n, ctx, slow, fast;
+        ee_u16   crc_one = 0;
+        ee_printf("Contexts Iterations/Sec Efficiency  Slowest ctx Iter/Sec  "
+                  "Fastest ctx Iter/Sec\n");
+        for (n = 1; n <= default_sweep_contexts; n++)
         {
-            results[i].err = 0;
-            if ((results[i].execs & ID_LIST)
-                && (results[i].crclist != list_known_crc[known_id]))
+            secs_ret ips;
+            total_time = run_contexts(results, n);
+            ips        = n * results[0].iterations / time_in_secs(total_time);
+            if (n == 1)
             {
-                ee_printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crclist,
-                          list_known_crc[known_id]);
-                results[i].err++;
+                ips_one = ips;
+                crc_one = results[0].crc;
             }
-            if ((results[i].execs & ID_MATRIX)
-                && (results[i].crcmatrix != matrix_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcmatrix,
-                          matrix_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_STATE)
-                && (results[i].crcstate != state_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcstate,
-                          state_known_crc[known_id]);
-                results[i].err++;
-            }
-            total_errors += results[i].err;
+            /* same seeds in every context, all must match the first step */
+            for (ctx = 0; ctx < n; ctx++)
+                if (results[ctx].crc != crc_one)
+                {
+                    ee_printf("[%u]ERROR! crcfinal 0x%04x - should be 0x%04x\n",
+                              ctx,
+                              results[ctx].crc,
+                              crc_one);
+                    sweep_errors++;
+                }
+            context_extremes(results, n, &slow, &fast);
+            ee_printf("%8u %14.3f %9.2f%% %7u %12.3f %7u %12.3f\n",
+                      n,
+                      ips,
+                      100.0 * ips / (n * ips_one),
+                      slow,
+                      context_ips(&results[slow]),
+                      fast,
+                      context_ips(&results[fast]));
         }
+        default_num_contexts = default_sweep_contexts;
     }
-    total_errors += check_data_types();
+    else
+#endif
+#endif
+        total_time = run_contexts(results, default_num_contexts);
+    /* get a function of the input to report */
+    seedcrc = seed_crc(results);
+
+    errors = known_crc_check(results, default_num_contexts, seedcrc, &known_id);
+    total_errors = (known_id < 0) ? errors : total_errors + errors;
+    /* the sweeps check their CRCs against their own reference runs, so their
+       errors count whatever the seeds, as do contexts that did not start */
+    sweep_errors += run_errors;
+    if (sweep_errors > 0)
+        total_errors
+            = (total_errors < 0) ? sweep_errors : total_errors + sweep_errors;
     /* and report results */
     ee_printf("CoreMark Size    : %lu\n", (long unsigned)results[0].size);
     ee_printf("Total ticks      : %lu\n", (long unsigned)total_time);
@@ -361,6 +919,7 @@ for (i = 0; i < MULTITHREAD; i++)
                   default_num_contexts * results[0].iterations
                       / time_in_secs(total_time));
 #endif
+    portable_timer_report();
     if (time_in_secs(total_time) < 10)
     {
         ee_printf(
@@ -372,10 +931,68 @@ for (i = 0; i < MULTITHREAD; i++)
               (long unsigned)default_num_contexts * results[0].iterations);
     ee_printf("Compiler version : %s\n", COMPILER_VERSION);
     ee_printf("Compiler flags   : %s\n", COMPILER_FLAGS);
+#if CORE_MATRIX_SIMD
+    ee_printf("Matrix kernels   : %s (non-compliant)\n", matrix_simd_isa);
+#endif
+#if CORE_LIST_INDEXED
+    ee_printf("List layout      : 16b index array (non-compliant)\n");
+#endif
+#if CORE_STATE_TABLE
+    ee_printf("State machine    : transition table (non-compliant)\n");
+#endif
+#if (CRC_METHOD != CRC_BITWISE)
+    ee_printf("CRC method       : %s\n",
+              (CRC_METHOD == CRC_TABLE) ? "slice-by-8 table" : "table + PCLMUL");
+#endif
 #if (MULTITHREAD > 1)
     ee_printf("Parallel %s : %d\n", PARALLEL_METHOD, default_num_contexts);
+#if HAS_FLOAT
+    /* every context stamped its own start and end, report them so a slow core
+       shows up instead of being averaged away */
+    {
+        secs_ret ips_sum = 0;
+        ee_u32   slow, fast;
+        CORE_TICKS first_start = results[0].start_stamp;
+        for (i = 1; i < default_num_contexts; i++)
+            if (results[i].start_stamp < first_start)
+                first_start = results[i].start_stamp;
+        for (i = 0; i < default_num_contexts; i++)
+        {
+            ee_printf("[%d]Context time  : +%f %f secs, %f Iter/Sec",
+                      i,
+                      time_in_secs(results[i].start_stamp - first_start),
+                      time_in_secs(results[i].stop_stamp
+                                   - results[i].start_stamp),
+                      context_ips(&results[i]));
+#if USE_PTHREAD_POOL
+            ee_printf(" (cpu %d)", results[i].port.cpu);
+#endif
+            ee_printf("\n");
+            ips_sum += context_ips(&results[i]);
+        }
+        context_extremes(results, default_num_contexts, &slow, &fast);
+        ee_printf("Slowest context  : [%u] %f Iter/Sec\n",
+                  slow,
+                  context_ips(&results[slow]));
+        ee_printf("Fastest context  : [%u] %f Iter/Sec\n",
+                  fast,
+                  context_ips(&results[fast]));
+        if (ips_sum > 0)
+            ee_printf("Context spread   : %.2f%%\n",
+                      100.0
+                          * (context_ips(&results[fast])
+                             - context_ips(&results[slow]))
+                          / (ips_sum / default_num_contexts));
+    }
+#endif
 #endif
     ee_printf("Memory location  : %s\n", MEM_LOCATION);
+#if (MEM_METHOD == MEM_MALLOC)
+    portable_mem_report();
+#endif
+#if CORE_KERNEL_PROFILE && HAS_FLOAT
+    kernel_report(results, default_num_contexts);
+#endif
 #ifdef PRINT_CRC
     /* output for verification */
     ee_printf("seedcrc          : 0x%04x\n", seedcrc);
@@ -395,7 +1012,9 @@ for (i = 0; i < MULTITHREAD; i++)
     {
         ee_printf("Correct operation validated.\n");
 #if HAS_FLOAT
-        if (known_id == 3)
+        if ((known_id == 3) && !CORE_COMPLIANT)
+            ee_printf("Non-compliant build, no CoreMark score reported.\n");
+        if ((known_id == 3) && CORE_COMPLIANT)
         {
             ee_printf("CoreMark 1.0 : %f / %s %s",
                       default_num_contexts * results[0].iterations
@@ -261,6 +261,7 @@ matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval)
     return ret;
 }
 
+#if !CORE_MATRIX_SIMD /* else see core_matrix_simd.c */
 /* Function: matrix_mul_const
         Multiply a matrix by a constant.
         This could be used as a scaler for instance.
@@ -357,3 +358,4 @@ matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
         }
     }
 }
+#endif
@@ -0,0 +1,383 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Original Author: Shay Gal-on
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        SIMD versions of the matrix kernels, replacing the ones in core_matrix.c
+   when <CORE_MATRIX_SIMD> is 1.
+
+        This is NOT the CoreMark reference code. A build using it is
+   non-compliant and does not report a CoreMark score. It exists to measure
+   how much of the matrix work the scalar reference leaves to a vectorizing
+   programmer. The results are bit-identical, so <matrix_known_crc> still
+   validates the run: MATDAT and MATRES arithmetic wraps the same way in
+   vector lanes, and the order of integer additions does not matter.
+
+        The instruction set is chosen at build time: AVX2 if the compiler
+   targets it, else SSE4.1, else blocked scalar loops.
+*/
+#if CORE_MATRIX_SIMD
+
+#define bit_extract(x, from, to) (((x) >> (from)) & (~(0xffffffff << (to))))
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+
+/* Vector operations on 16b and 32b lanes, VEC_S16 is the number of 16b
+   lanes. The widening macros return the low or high half of the 16b lanes as
+   32b lanes, in order. */
+#if defined(__AVX2__)
+const char *matrix_simd_isa = "AVX2";
+typedef __m256i vec;
+#define VEC_S16          16
+#define v_load(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define v_store(p, v)    _mm256_storeu_si256((__m256i *)(p), v)
+#define v_zero()         _mm256_setzero_si256()
+#define v_set16(x)       _mm256_set1_epi16(x)
+#define v_set32(x)       _mm256_set1_epi32(x)
+#define v_add16(a, b)    _mm256_add_epi16(a, b)
+#define v_add32(a, b)    _mm256_add_epi32(a, b)
+#define v_mullo16(a, b)  _mm256_mullo_epi16(a, b)
+#define v_mullo32(a, b)  _mm256_mullo_epi32(a, b)
+#define v_madd16(a, b)   _mm256_madd_epi16(a, b)
+#define v_srli16(a, n)   _mm256_srli_epi16(a, n)
+#define v_and(a, b)      _mm256_and_si256(a, b)
+#define v_unpacklo(a, b) _mm256_unpacklo_epi16(a, b)
+#define v_unpackhi(a, b) _mm256_unpackhi_epi16(a, b)
+#define v_lo_s32(v)      _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v))
+#define v_hi_s32(v)      _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1))
+#define v_lo_u32(v)      _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v))
+#define v_hi_u32(v)      _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1))
+/* unpack works within 128b lanes, put the columns back in order */
+#define v_store_pairs(p, lo, hi)                                         \
+    do                                                                   \
+    {                                                                    \
+        v_store(p, _mm256_permute2x128_si256(lo, hi, 0x20));             \
+        v_store((p) + VEC_S16 / 2, _mm256_permute2x128_si256(lo, hi, 0x31)); \
+    } while (0)
+static ee_s32
+v_hsum32(vec v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+    s         = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+    s         = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+    return _mm_cvtsi128_si32(s);
+}
+#else
+const char *matrix_simd_isa = "SSE4.1";
+typedef __m128i vec;
+#define VEC_S16          8
+#define v_load(p)        _mm_loadu_si128((const __m128i *)(p))
+#define v_store(p, v)    _mm_storeu_si128((__m128i *)(p), v)
+#define v_zero()         _mm_setzero_si128()
+#define v_set16(x)       _mm_set1_epi16(x)
+#define v_set32(x)       _mm_set1_epi32(x)
+#define v_add16(a, b)    _mm_add_epi16(a, b)
+#define v_add32(a, b)    _mm_add_epi32(a, b)
+#define v_mullo16(a, b)  _mm_mullo_epi16(a, b)
+#define v_mullo32(a, b)  _mm_mullo_epi32(a, b)
+#define v_madd16(a, b)   _mm_madd_epi16(a, b)
+#define v_srli16(a, n)   _mm_srli_epi16(a, n)
+#define v_and(a, b)      _mm_and_si128(a, b)
+#define v_unpacklo(a, b) _mm_unpacklo_epi16(a, b)
+#define v_unpackhi(a, b) _mm_unpackhi_epi16(a, b)
+#define v_lo_s32(v)      _mm_cvtepi16_epi32(v)
+#define v_hi_s32(v)      _mm_cvtepi16_epi32(_mm_srli_si128(v, 8))
+#define v_lo_u32(v)      _mm_cvtepu16_epi32(v)
+#define v_hi_u32(v)      _mm_cvtepu16_epi32(_mm_srli_si128(v, 8))
+#define v_store_pairs(p, lo, hi)             \
+    do                                       \
+    {                                        \
+        v_store(p, lo);                      \
+        v_store((p) + VEC_S16 / 2, hi);      \
+    } while (0)
+static ee_s32
+v_hsum32(vec v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4e));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xb1));
+    return _mm_cvtsi128_si32(v);
+}
+#endif
+
+/* Function: matrix_add_const
+        Add a constant value to all elements of a matrix.
+*/
+void
+matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val)
+{
+    ee_u32 i, NN = N * N;
+    vec    v = v_set16(val);
+    for (i = 0; i + VEC_S16 <= NN; i += VEC_S16)
+        v_store(&A[i], v_add16(v_load(&A[i]), v));
+    for (; i < NN; i++)
+        A[i] += val;
+}
+
+/* Function: matrix_mul_const
+        Multiply a matrix by a constant, widening to MATRES.
+*/
+void
+matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
+{
+    ee_u32 i, NN = N * N;
+    vec    v = v_set32(val);
+    for (i = 0; i + VEC_S16 <= NN; i += VEC_S16)
+    {
+        vec a = v_load(&A[i]);
+        v_store(&C[i], v_mullo32(v_lo_s32(a), v));
+        v_store(&C[i + VEC_S16 / 2], v_mullo32(v_hi_s32(a), v));
+    }
+    for (; i < NN; i++)
+        C[i] = (MATRES)A[i] * (MATRES)val;
+}
+
+/* Function: matrix_mul_vect
+        Multiply a matrix by a vector, pairs of 16b products summed by madd.
+*/
+void
+matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j;
+    for (i = 0; i < N; i++)
+    {
+        vec acc = v_zero();
+        for (j = 0; j + VEC_S16 <= N; j += VEC_S16)
+            acc = v_add32(acc, v_madd16(v_load(&A[i * N + j]), v_load(&B[j])));
+        C[i] = v_hsum32(acc);
+        for (; j < N; j++)
+            C[i] += (MATRES)A[i * N + j] * (MATRES)B[j];
+    }
+}
+
+/* Function: mul_matrix_block
+        Compute <rows> (at most 4) rows by VEC_S16 columns of C = A * B,
+   starting at row i and column j.
+
+        Rows k and k+1 of B are interleaved, so madd of one interleaved vector
+   with the pair A[r][k], A[r][k+1] broadcast to all 32b lanes adds two terms
+   of every column at once. The 2 x rows accumulators stay in registers over
+   the whole k loop.
+*/
+static inline void
+mul_matrix_block(ee_u32  N,
+                 MATRES *C,
+                 MATDAT *A,
+                 MATDAT *B,
+                 ee_u32  i,
+                 ee_u32  j,
+                 ee_u32  rows)
+{
+    vec    acc[4][2];
+    ee_u32 k, r;
+    for (r = 0; r < rows; r++)
+        acc[r][0] = acc[r][1] = v_zero();
+    for (k = 0; k < N; k += 2)
+    {
+        vec b0 = v_load(&B[k * N + j]);
+        vec b1 = (k + 1 < N) ? v_load(&B[(k + 1) * N + j]) : v_zero();
+        vec lo = v_unpacklo(b0, b1);
+        vec hi = v_unpackhi(b0, b1);
+        for (r = 0; r < rows; r++)
+        {
+            const MATDAT *a  = &A[(i + r) * N + k];
+            ee_u32        a2 = (ee_u16)a[0];
+            vec           v;
+            if (k + 1 < N)
+                a2 |= (ee_u32)(ee_u16)a[1] << 16;
+            v         = v_set32((ee_s32)a2);
+            acc[r][0] = v_add32(acc[r][0], v_madd16(lo, v));
+            acc[r][1] = v_add32(acc[r][1], v_madd16(hi, v));
+        }
+    }
+    for (r = 0; r < rows; r++)
+        v_store_pairs(&C[(i + r) * N + j], acc[r][0], acc[r][1]);
+}
+
+/* Function: matrix_mul_matrix
+        Multiply a matrix by a matrix, register blocked 4 rows by one vector of
+   columns. Columns beyond the last full vector are done in scalar code.
+*/
+void
+matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k, r, rows;
+    for (i = 0; i < N; i += rows)
+    {
+        rows = (N - i < 4) ? N - i : 4;
+        for (j = 0; j + VEC_S16 <= N; j += VEC_S16)
+        {
+            if (rows == 4)
+                mul_matrix_block(N, C, A, B, i, j, 4);
+            else
+                mul_matrix_block(N, C, A, B, i, j, rows);
+        }
+        for (r = i; r < i + rows; r++)
+        {
+            ee_u32 jj;
+            for (jj = j; jj < N; jj++)
+            {
+                C[r * N + jj] = 0;
+                for (k = 0; k < N; k++)
+                    C[r * N + jj] += (MATRES)A[r * N + k] * (MATRES)B[k * N + jj];
+            }
+        }
+    }
+}
+
+/* Function: matrix_mul_matrix_bitextract
+        Multiply a matrix by a matrix, and extract some bits from the result.
+
+        Both extracted fields lie in the low 16 bits of every product, so the
+   products are formed with 16b multiplies. The product of the fields is at
+   most 15 * 127, so 16 of them are summed in 16b lanes before widening to the
+   32b accumulators.
+*/
+void
+matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k;
+    vec    m4 = v_set16(0xf), m7 = v_set16(0x7f);
+    for (i = 0; i < N; i++)
+    {
+        for (j = 0; j + VEC_S16 <= N; j += VEC_S16)
+        {
+            vec lo = v_zero(), hi = v_zero();
+            for (k = 0; k < N;)
+            {
+                ee_u32 kend = (N - k < 16) ? N : k + 16;
+                vec    acc  = v_zero();
+                for (; k < kend; k++)
+                {
+                    vec t = v_mullo16(v_set16(A[i * N + k]),
+                                      v_load(&B[k * N + j]));
+                    acc   = v_add16(acc,
+                                  v_mullo16(v_and(v_srli16(t, 2), m4),
+                                            v_and(v_srli16(t, 5), m7)));
+                }
+                lo = v_add32(lo, v_lo_u32(acc));
+                hi = v_add32(hi, v_hi_u32(acc));
+            }
+            v_store(&C[i * N + j], lo);
+            v_store(&C[i * N + j + VEC_S16 / 2], hi);
+        }
+        for (; j < N; j++)
+        {
+            C[i * N + j] = 0;
+            for (k = 0; k < N; k++)
+            {
+                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                C[i * N + j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
+            }
+        }
+    }
+}
+
+#else /* neither AVX2 nor SSE4.1 */
+const char *matrix_simd_isa = "scalar";
+
+/* Function: matrix_add_const
+        Add a constant value to all elements of a matrix.
+*/
+void
+matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val)
+{
+    ee_u32 i, NN = N * N;
+    for (i = 0; i < NN; i++)
+        A[i] += val;
+}
+
+/* Function: matrix_mul_const
+        Multiply a matrix by a constant.
+*/
+void
+matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
+{
+    ee_u32 i, NN = N * N;
+    for (i = 0; i < NN; i++)
+        C[i] = (MATRES)A[i] * (MATRES)val;
+}
+
+/* Function: matrix_mul_vect
+        Multiply a matrix by a vector, accumulating in a local.
+*/
+void
+matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j;
+    for (i = 0; i < N; i++)
+    {
+        MATRES sum = 0;
+        for (j = 0; j < N; j++)
+            sum += (MATRES)A[i * N + j] * (MATRES)B[j];
+        C[i] = sum;
+    }
+}
+
+/* Function: matrix_mul_matrix
+        Multiply a matrix by a matrix in i-k-j order, so the inner loop streams
+   rows of B and C and can be vectorized by the compiler.
+*/
+void
+matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        MATRES *c = &C[i * N];
+        for (j = 0; j < N; j++)
+            c[j] = 0;
+        for (k = 0; k < N; k++)
+        {
+            MATRES  a = A[i * N + k];
+            MATDAT *b = &B[k * N];
+            for (j = 0; j < N; j++)
+                c[j] += a * (MATRES)b[j];
+        }
+    }
+}
+
+/* Function: matrix_mul_matrix_bitextract
+        Multiply a matrix by a matrix, and extract some bits from the result,
+   in i-k-j order.
+*/
+void
+matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        MATRES *c = &C[i * N];
+        for (j = 0; j < N; j++)
+            c[j] = 0;
+        for (k = 0; k < N; k++)
+        {
+            MATRES  a = A[i * N + k];
+            MATDAT *b = &B[k * N];
+            for (j = 0; j < N; j++)
+            {
+                MATRES tmp = a * (MATRES)b[j];
+                c[j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
+            }
+        }
+    }
+}
+#endif
+#endif /* CORE_MATRIX_SIMD */
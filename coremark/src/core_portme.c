@@ -16,12 +16,32 @@ limitations under the License.
 Original Author: Shay Gal-on
 */
 
+/* 2026-10-17: _GNU_SOURCE is needed for the CPU affinity calls used by the
+ *             pinned thread pool.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include "coremark.h"
+#include <string.h>
+#if (MULTITHREAD>1) || defined(__linux__)
+#include <unistd.h> /* for sysconf */
+#endif
+#if (MEM_METHOD==MEM_MALLOC) && defined(__linux__)
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 #if CALLGRIND_RUN
 #include <valgrind/callgrind.h>
 #endif
+#include <signal.h>
+
+ee_u32 default_mem_policy=MEM_POLICY_MALLOC;
+static const char *mem_policy_name[]={"malloc","line","page","thp","hugetlb","local","interleave"};
 
 #if (MEM_METHOD==MEM_MALLOC)
 /* 2022-07-26: malloc.h is not available under macOS, where malloc() is
@@ -30,17 +50,150 @@ Original Author: Shay Gal-on
 #ifndef __MACH__
 #include <malloc.h>
 #endif
+#if defined(__linux__)
+#define HUGE_PAGE_SIZE (2*1024*1024)
+#define MPOL_INTERLEAVE_MODE 3 /* MPOL_INTERLEAVE from <linux/mempolicy.h> */
+
+/* Type: mem_map_hdr
+	Stored right below every block returned by <portable_malloc>, to release it again
+	the way it was allocated: unmapped if <len> is not 0, freed from <base> otherwise.
+	The policy may change after a fallback, so <portable_free> cannot go by the policy.
+*/
+typedef struct MEM_MAP_HDR_S {
+	void *base;
+	size_t len;
+} mem_map_hdr;
+
+/* Function: mem_map
+	Map an anonymous block of <size> bytes aligned to <align>.
+	The pages are not touched, except the one holding the <mem_map_hdr> below the block.
+*/
+static void *mem_map(size_t size, size_t align, int flags) {
+	size_t len=(size+2*align+align-1)/align*align;
+	char *base, *p;
+	mem_map_hdr *hdr;
+	base=(char *)mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|flags, -1, 0);
+	if (base==(char *)MAP_FAILED)
+		return NULL;
+	p=(char *)(((uintptr_t)base+sizeof(mem_map_hdr)+align-1) & ~(uintptr_t)(align-1));
+	hdr=(mem_map_hdr *)p - 1;
+	hdr->base=base;
+	hdr->len=len;
+	return p;
+}
+
+/* Function: mem_heap
+	Allocate <size> bytes from the heap aligned to <align> (malloc alignment if 0),
+	with a <mem_map_hdr> telling <portable_free> to free the block.
+*/
+static void *mem_heap(size_t size, size_t align) {
+	size_t off=(align>sizeof(mem_map_hdr)) ? align : sizeof(mem_map_hdr);
+	void *base=NULL;
+	char *p;
+	if (align==0)
+		base=malloc(size+off);
+	else if (posix_memalign(&base, align, size+off)!=0)
+		base=NULL;
+	if (base==NULL)
+		return NULL;
+	p=(char *)base+off;
+	((mem_map_hdr *)p - 1)->base=base;
+	((mem_map_hdr *)p - 1)->len=0;
+	return p;
+}
+
+static void mem_fallback(ee_u32 policy, const char *why) {
+	ee_printf("WARNING! %s, memory placement falls back to %s\n", why, mem_policy_name[policy]);
+	default_mem_policy=policy;
+}
+#endif
+
 /* Function: portable_malloc
 	Provide malloc() functionality in a platform specific way.
+	The block is placed according to <default_mem_policy>.
 */
 void *portable_malloc(size_t size) {
+	void *p=NULL;
+#if defined(__linux__)
+	size_t page=(size_t)sysconf(_SC_PAGESIZE);
+	if (default_mem_policy==MEM_POLICY_HUGETLB) {
+		p=mem_map(size, HUGE_PAGE_SIZE, MAP_HUGETLB);
+		if (p==NULL)
+			mem_fallback(MEM_POLICY_THP, "No hugetlbfs pages available (see /proc/sys/vm/nr_hugepages)");
+	}
+	if (default_mem_policy==MEM_POLICY_THP) {
+		p=mem_map(size, HUGE_PAGE_SIZE, 0);
+		if ((p!=NULL) && (madvise(p, (size+HUGE_PAGE_SIZE-1)/HUGE_PAGE_SIZE*HUGE_PAGE_SIZE, MADV_HUGEPAGE)!=0))
+			ee_printf("WARNING! madvise(MADV_HUGEPAGE) failed, transparent hugepages may be disabled\n");
+	}
+	if ((default_mem_policy==MEM_POLICY_LOCAL) || (default_mem_policy==MEM_POLICY_INTERLEAVE))
+		p=mem_map(size, page, 0);
+	if ((p!=NULL) && (default_mem_policy==MEM_POLICY_INTERLEAVE)) {
+		unsigned long nodes[16];
+		memset(nodes, 0xff, sizeof(nodes)); /* the kernel keeps the allowed nodes with memory */
+		if (syscall(SYS_mbind, p, (size+page-1)/page*page, MPOL_INTERLEAVE_MODE, nodes, sizeof(nodes)*8, 0)!=0) {
+			portable_free(p);
+			p=NULL;
+			mem_fallback(MEM_POLICY_PAGE, "mbind(MPOL_INTERLEAVE) failed");
+		}
+	}
+	if (p!=NULL)
+		return p;
+	if (default_mem_policy>MEM_POLICY_PAGE)
+		mem_fallback(MEM_POLICY_PAGE, "mmap failed");
+	if (default_mem_policy==MEM_POLICY_LINE)
+		return mem_heap(size, 64);
+	if (default_mem_policy==MEM_POLICY_PAGE)
+		return mem_heap(size, page);
+	return mem_heap(size, 0);
+#else
+	size_t page=4096;
+	if (default_mem_policy>MEM_POLICY_PAGE)
+		ee_printf("WARNING! Memory placement %s needs Linux, falls back to page\n", mem_policy_name[default_mem_policy]);
+	if (default_mem_policy>MEM_POLICY_PAGE)
+		default_mem_policy=MEM_POLICY_PAGE;
+	if (default_mem_policy==MEM_POLICY_LINE)
+		return (posix_memalign(&p, 64, size)==0) ? p : NULL;
+	if (default_mem_policy==MEM_POLICY_PAGE)
+		return (posix_memalign(&p, page, size)==0) ? p : NULL;
 	return malloc(size);
+#endif
 }
 /* Function: portable_free
 	Provide free() functionality in a platform specific way.
 */
 void portable_free(void *p) {
+#if defined(__linux__)
+	mem_map_hdr *hdr=(mem_map_hdr *)p - 1;
+	if (p==NULL)
+		return;
+	if (hdr->len!=0)
+		munmap(hdr->base, hdr->len);
+	else
+		free(hdr->base);
+#else
 	free(p);
+#endif
+}
+
+/* Function: portable_mem_report
+	Print the placement policy of the data blocks.
+	For transparent hugepages also print how much of the process is backed by them,
+	as the kernel may ignore the advice.
+*/
+void portable_mem_report(void) {
+	ee_printf("Memory placement : %s\n", mem_policy_name[default_mem_policy]);
+#if defined(__linux__)
+	if (default_mem_policy==MEM_POLICY_THP) {
+		FILE *f=fopen("/proc/self/smaps_rollup", "r");
+		char line[128];
+		while ((f!=NULL) && (fgets(line, sizeof(line), f)!=NULL))
+			if (strncmp(line, "AnonHugePages:", 14)==0)
+				ee_printf("Memory hugepages : %s", line+14+strspn(line+14, " "));
+		if (f!=NULL)
+			fclose(f);
+	}
+#endif
 }
 #else
 void *portable_malloc(size_t size) {
@@ -49,6 +202,8 @@ void *portable_malloc(size_t size) {
 void portable_free(void *p) {
 	p=NULL;
 }
+void portable_mem_report(void) {
+}
 #endif
 
 #if (SEED_METHOD==SEED_VOLATILE)
@@ -88,6 +243,8 @@ void portable_free(void *p) {
 	#define GETMYTIME(_t) (*_t=clock())
 	#define MYTIMEDIFF(fin,ini) ((fin)-(ini))
 	#define TIMER_RES_DIVIDER 1
+	#define TIMER_NAME "clock()"
+	#define TIMER_WARNING "process CPU time, not elapsed time"
 	#define SAMPLE_TIME_IMPLEMENTATION 1
 #elif defined(_MSC_VER)
 	#define NSECS_PER_SEC 10000000
@@ -99,6 +256,38 @@ void portable_free(void *p) {
 	#ifndef TIMER_RES_DIVIDER
 	#define TIMER_RES_DIVIDER 1000
 	#endif
+	#define TIMER_NAME "GetSystemTimeAsFileTime"
+	#define TIMER_WARNING "wall clock, may be adjusted during the run"
+	#define SAMPLE_TIME_IMPLEMENTATION 1
+#elif USE_TSC
+	#if !(defined(__x86_64__) || defined(__i386__))
+	#error "USE_TSC is only available on x86"
+	#endif
+	#if !HAS_FLOAT
+	#error "USE_TSC needs HAS_FLOAT for the calibrated tick rate"
+	#endif
+	#include <x86intrin.h>
+	#include <cpuid.h>
+	#define NSECS_PER_SEC tsc_ticks_per_sec /* calibrated in portable_init */
+	#define EE_TIMER_TICKER_RATE 1000
+	#define CORETIMETYPE unsigned long long
+	#define GETMYTIME(_t) (*_t=__rdtsc())
+	#define MYTIMEDIFF(fin,ini) ((fin)-(ini))
+	#define TIMER_RES_DIVIDER 1
+	#define TIMER_NAME "TSC (calibrated)"
+	#define SAMPLE_TIME_IMPLEMENTATION 1
+#elif USE_MONOTONIC_RAW
+	#define NSECS_PER_SEC 1000000000
+	#define EE_TIMER_TICKER_RATE 1000
+	#define CORETIMETYPE struct timespec 
+	#define GETMYTIME(_t) clock_gettime(CLOCK_MONOTONIC_RAW,_t)
+	#define MYTIMEDIFF(fin,ini) ((fin.tv_sec-ini.tv_sec)*(NSECS_PER_SEC/TIMER_RES_DIVIDER)+(fin.tv_nsec-ini.tv_nsec)/TIMER_RES_DIVIDER)
+	/* full nanosecond resolution, CORE_TICKS is 64b for this timer */
+	#ifndef TIMER_RES_DIVIDER
+	#define TIMER_RES_DIVIDER 1
+	#endif
+	#define TIMER_NAME "CLOCK_MONOTONIC_RAW"
+	#define TIMER_CLOCK_ID CLOCK_MONOTONIC_RAW
 	#define SAMPLE_TIME_IMPLEMENTATION 1
 #elif HAS_TIME_H
 	#define NSECS_PER_SEC 1000000000
@@ -110,6 +299,9 @@ void portable_free(void *p) {
 	#ifndef TIMER_RES_DIVIDER
 	#define TIMER_RES_DIVIDER 1000000
 	#endif
+	#define TIMER_NAME "CLOCK_REALTIME"
+	#define TIMER_CLOCK_ID CLOCK_REALTIME
+	#define TIMER_WARNING "wall clock, NTP may step or slew it during the run"
 	#define SAMPLE_TIME_IMPLEMENTATION 1
 #else
 	#define SAMPLE_TIME_IMPLEMENTATION 0
@@ -118,7 +310,41 @@ void portable_free(void *p) {
 
 #if SAMPLE_TIME_IMPLEMENTATION
 /** Define Host specific (POSIX), or target specific global time variables. */
-static CORETIMETYPE start_time_val, stop_time_val;
+static CORETIMETYPE start_time_val, stop_time_val, epoch_time_val;
+/* Timer problems found at run time, printed by <portable_timer_report> */
+static const char *timer_warning[4];
+static int timer_warnings=0;
+
+#if USE_TSC
+static secs_ret tsc_ticks_per_sec=1.0;
+
+/* Function: tsc_calibrate
+	Measure the TSC frequency against CLOCK_MONOTONIC_RAW.
+
+	Two back to back windows of 100ms are measured and averaged.
+	If they disagree the TSC is not a reliable time base on this system and a warning is recorded.
+*/
+static void tsc_calibrate(void) {
+	secs_ret rate[2];
+	unsigned int eax, ebx, ecx, edx;
+	int k;
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u<<8)))
+		timer_warning[timer_warnings++]="CPU does not report an invariant TSC, frequency changes skew the results";
+	for (k=0; k<2; k++) {
+		struct timespec t0, t1, nap={0, 100000000};
+		unsigned long long c0, c1;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		c0=__rdtsc();
+		nanosleep(&nap, NULL);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+		c1=__rdtsc();
+		rate[k]=(secs_ret)(c1-c0) / ((t1.tv_sec-t0.tv_sec) + (t1.tv_nsec-t0.tv_nsec)*1e-9);
+	}
+	tsc_ticks_per_sec=(rate[0]+rate[1])/2;
+	if ((rate[0]-rate[1])/tsc_ticks_per_sec > 0.001 || (rate[1]-rate[0])/tsc_ticks_per_sec > 0.001)
+		timer_warning[timer_warnings++]="TSC calibration windows differ by more than 0.1%";
+}
+#endif /* USE_TSC */
 
 /* Function: start_time
 	This function will be called right before starting the timed portion of the benchmark.
@@ -173,11 +399,291 @@ secs_ret time_in_secs(CORE_TICKS ticks) {
 	secs_ret retval=((secs_ret)ticks) / (secs_ret)EE_TICKS_PER_SEC;
 	return retval;
 }
+/* Function: portable_timer_report
+	Print the timer used for the measurement, its resolution, and any known problem with it,
+	so results taken with different timers can be told apart.
+*/
+void portable_timer_report(void) {
+	secs_ret res=(secs_ret)1 / (secs_ret)EE_TICKS_PER_SEC;
+	int i;
+#if defined(TIMER_CLOCK_ID)
+	struct timespec clock_res;
+	if (clock_getres(TIMER_CLOCK_ID, &clock_res)==0 && clock_res.tv_sec==0 && clock_res.tv_nsec*1e-9 > res)
+		res=clock_res.tv_nsec*1e-9;
+#endif
+#if HAS_FLOAT
+	ee_printf("Timer            : %s, %.3f ns resolution\n", TIMER_NAME, res*1e9);
+#else
+	ee_printf("Timer            : %s\n", TIMER_NAME);
+#endif
+#if defined(TIMER_WARNING)
+	ee_printf("WARNING! Timer is a %s\n", TIMER_WARNING);
+#endif
+	for (i=0; i<timer_warnings; i++)
+		ee_printf("WARNING! %s\n", timer_warning[i]);
+}
+/* Function: get_time_stamp
+	Return the ticks elapsed since <portable_init>.
+
+	Unlike <start_time>/<stop_time> this keeps no state, so every context can stamp
+	its own start and end, and stamps taken by different contexts can be compared.
+*/
+CORE_TICKS get_time_stamp(void) {
+	CORETIMETYPE now;
+	GETMYTIME(&now);
+	return (CORE_TICKS)(MYTIMEDIFF(now, epoch_time_val));
+}
 #else 
 #error "Please implement timing functionality in core_portme.c"
 #endif /* SAMPLE_TIME_IMPLEMENTATION */
 
+#if CORE_KERNEL_PROFILE
+/* Porting: CPU counters
+	Counters charged to the kernels with <CORE_KERNEL_PROFILE>. On Linux the cycles,
+	instructions and branch misses of the calling thread are counted in user mode
+	with perf_event_open, as one group so a single read returns all of them.
+	Where they cannot be opened (no PMU, perf_event_paranoid, other platforms)
+	only the ticks are counted and the others read 0.
+*/
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+static const unsigned long long counter_config[NUM_COUNTERS-1] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+void portable_counters_open(core_portable *p) {
+	struct perf_event_attr attr;
+	ee_u32 i;
+	for (i=0; i<NUM_COUNTERS-1; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size=sizeof(attr);
+		attr.type=PERF_TYPE_HARDWARE;
+		attr.config=counter_config[i];
+		attr.read_format=PERF_FORMAT_GROUP;
+		attr.exclude_kernel=1;
+		attr.exclude_hv=1;
+		p->counters_fd[i]=(int)syscall(SYS_perf_event_open, &attr, 0, -1, (i==0) ? -1 : p->counters_fd[0], 0);
+		if (p->counters_fd[i]<0) { /* all or nothing */
+			portable_counters_close(p);
+			return;
+		}
+	}
+}
+void portable_counters_read(core_portable *p, ee_counter *v) {
+	unsigned long long group[NUM_COUNTERS]; /* count of events, then their values */
+	ee_u32 i;
+	v[0]=get_time_stamp();
+	if ((p->counters_fd[0]<0) || (read(p->counters_fd[0], group, sizeof(group))!=sizeof(group)))
+		memset(group, 0, sizeof(group));
+	for (i=1; i<NUM_COUNTERS; i++)
+		v[i]=group[i];
+}
+void portable_counters_close(core_portable *p) {
+	ee_u32 i;
+	for (i=0; i<NUM_COUNTERS-1; i++) {
+		if (p->counters_fd[i]>=0)
+			close(p->counters_fd[i]);
+		p->counters_fd[i]=-1;
+	}
+}
+#else
+void portable_counters_open(core_portable *p) {
+	ee_u32 i;
+	for (i=0; i<NUM_COUNTERS-1; i++)
+		p->counters_fd[i]=-1;
+}
+void portable_counters_read(core_portable *p, ee_counter *v) {
+	ee_u32 i;
+	v[0]=get_time_stamp();
+	for (i=1; i<NUM_COUNTERS; i++)
+		v[i]=0;
+}
+void portable_counters_close(core_portable *p) {
+}
+#endif
+#endif /* CORE_KERNEL_PROFILE */
+
 ee_u32 default_num_contexts=MULTITHREAD;
+ee_u32 default_sweep_contexts=0;
+ee_u32 default_sweep_size=0;
+ee_u32 default_continuous_secs=0;
+
+#if (MULTITHREAD>1) && USE_PTHREAD_POOL
+/* Type: core_worker
+	One persistent worker of the thread pool.
+	The worker sleeps on <go> until a context is assigned to it, waits on the shared
+	start barrier, runs the context, and signals <done>. <iterate> stamps the start
+	and end of the context itself.
+*/
+typedef struct CORE_WORKER_S {
+	pthread_t thread;
+	sem_t go;
+	sem_t done;
+	core_results *res;
+	void *touch;
+	size_t touch_size;
+	ee_s32 cpu;
+	ee_u8 quit;
+} core_worker;
+
+static core_worker pool[MULTITHREAD];
+static ee_u32 pool_size=0;
+static ee_u32 pool_next=0;
+static ee_u32 pool_busy=0;
+static pthread_barrier_t pool_barrier;
+static ee_u8 pool_barrier_ready=0;
+
+static void *pool_worker(void *arg) {
+	core_worker *w=(core_worker *)arg;
+	while (1) {
+		while (sem_wait(&w->go)!=0)
+			;
+		if (w->quit)
+			break;
+		if (w->touch!=NULL) { /* first touch of a data block, see <portable_first_touch> */
+			memset(w->touch, 0, w->touch_size);
+			w->touch=NULL;
+			sem_post(&w->done);
+			continue;
+		}
+		pthread_barrier_wait(&pool_barrier);
+		iterate(w->res);
+		sem_post(&w->done);
+	}
+	return NULL;
+}
+
+/* Function: pool_spawn
+	Make sure at least <n> workers exist.
+	Worker i is pinned to the i-th CPU of the process affinity mask (wrapping around),
+	so contexts never migrate and never share a CPU unless there are more contexts than CPUs.
+*/
+static void pool_spawn(ee_u32 n) {
+	cpu_set_t allowed;
+	int ncpus=0, c;
+	int cpus[CPU_SETSIZE];
+	if (n>MULTITHREAD)
+		n=MULTITHREAD;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed)==0) {
+		for (c=0; c<CPU_SETSIZE; c++)
+			if (CPU_ISSET(c, &allowed))
+				cpus[ncpus++]=c;
+	}
+	while (pool_size<n) {
+		core_worker *w=&pool[pool_size];
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		w->cpu=-1;
+		if (ncpus>0) {
+			cpu_set_t mask;
+			CPU_ZERO(&mask);
+			w->cpu=cpus[pool_size % ncpus];
+			CPU_SET(w->cpu, &mask);
+			if (pthread_attr_setaffinity_np(&attr, sizeof(mask), &mask)!=0) {
+				ee_printf("WARNING! Could not pin worker %u to cpu %d\n", pool_size, w->cpu);
+				w->cpu=-1;
+			}
+		}
+		w->quit=0;
+		w->touch=NULL;
+		sem_init(&w->go, 0, 0);
+		sem_init(&w->done, 0, 0);
+		if (pthread_create(&w->thread, &attr, pool_worker, w)!=0) {
+			ee_printf("ERROR creating pool worker %u!\n", pool_size);
+			pthread_attr_destroy(&attr);
+			break;
+		}
+		pthread_attr_destroy(&attr);
+		pool_size++;
+	}
+}
+
+static void pool_shutdown(void) {
+	ee_u32 i;
+	for (i=0; i<pool_size; i++) {
+		pool[i].quit=1;
+		sem_post(&pool[i].go);
+		pthread_join(pool[i].thread, NULL);
+		sem_destroy(&pool[i].go);
+		sem_destroy(&pool[i].done);
+	}
+	pool_size=0;
+	if (pool_barrier_ready) {
+		pthread_barrier_destroy(&pool_barrier);
+		pool_barrier_ready=0;
+	}
+}
+#endif /* MULTITHREAD>1 && USE_PTHREAD_POOL */
+
+/* Function: portable_first_touch
+	With the local placement policy, have the pinned pool worker that will run context <ctx>
+	write the block first, so the kernel places its pages on the NUMA node of that worker.
+	Other policies leave the block alone.
+*/
+void portable_first_touch(void *p, ee_size_t size, ee_u32 ctx) {
+	if ((default_mem_policy!=MEM_POLICY_LOCAL) || (p==NULL))
+		return;
+#if (MULTITHREAD>1) && USE_PTHREAD_POOL
+	if (ctx>=pool_size)
+		pool_spawn(ctx+1);
+	if (ctx<pool_size) {
+		pool[ctx].touch_size=size;
+		pool[ctx].touch=p;
+		sem_post(&pool[ctx].go);
+		while (sem_wait(&pool[ctx].done)!=0)
+			;
+		return;
+	}
+#endif
+#if !((MULTITHREAD>1) && USE_PTHREAD_POOL)
+	(void)ctx;
+#endif
+	memset(p, 0, size);
+}
+
+static volatile sig_atomic_t stop_requested=0;
+
+/* Function: stop_handler
+	SIGINT handler of continuous mode: let the run finish its current iterations
+	and report. A second SIGINT terminates as usual.
+*/
+static void stop_handler(int sig) {
+	stop_requested=1;
+	signal(sig, SIG_DFL);
+}
+
+ee_u8 portable_stop_requested(void) {
+	return stop_requested ? 1 : 0;
+}
+
+/* Function: portable_freq_report
+	Print the current frequency of every CPU in MHz, as the cpufreq driver reports it.
+	Prints nothing where there is no cpufreq.
+*/
+void portable_freq_report(void) {
+#if defined(__linux__)
+	long cpus=sysconf(_SC_NPROCESSORS_CONF), cpu;
+	int shown=0;
+	for (cpu=0; cpu<cpus; cpu++) {
+		char path[80];
+		unsigned long khz;
+		FILE *f;
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/scaling_cur_freq", cpu);
+		f=fopen(path, "r");
+		if (f==NULL)
+			continue;
+		if (fscanf(f, "%lu", &khz)==1) {
+			if (!shown)
+				ee_printf("  MHz");
+			ee_printf(" %ld:%lu", cpu, khz/1000);
+			shown=1;
+		}
+		fclose(f);
+	}
+#endif
+}
 
 /* Function: portable_init
 	Target specific initialization code 
@@ -202,13 +708,50 @@ void portable_init(core_portable *p, int *argc, char *argv[])
 	ee_printf("ERROR! Main has no argc, but SEED_METHOD defined to SEED_ARG!\n");
 #endif
 	
-#if (MULTITHREAD>1) && (SEED_METHOD==SEED_ARG)
+#if USE_TSC
+	tsc_calibrate();
+#endif
+	GETMYTIME(&epoch_time_val);
+#if (SEED_METHOD==SEED_ARG)
 	{
 		int nargs=*argc,i;
-		if ((nargs>1) && (*argv[1]=='M')) {
-			default_num_contexts=parseval(argv[1]+1);
-			if (default_num_contexts>MULTITHREAD)
-				default_num_contexts=MULTITHREAD;
+		while ((nargs>1) && ((*argv[1]=='M') || (*argv[1]=='S') || (*argv[1]=='W') || (*argv[1]=='P') || (*argv[1]=='C'))) {
+			if (*argv[1]=='P') {
+				ee_u32 policy;
+				for (policy=0; policy<sizeof(mem_policy_name)/sizeof(mem_policy_name[0]); policy++)
+					if (strcmp(argv[1]+1, mem_policy_name[policy])==0)
+						break;
+				if (policy<sizeof(mem_policy_name)/sizeof(mem_policy_name[0]))
+					default_mem_policy=policy;
+				else
+					ee_printf("WARNING! Unknown memory placement %s, use malloc, line, page, thp, hugetlb, local or interleave\n", argv[1]+1);
+			} else if (*argv[1]=='C') {
+				default_continuous_secs=parseval(argv[1]+1);
+				if (default_continuous_secs==0)
+					default_continuous_secs=10;
+				signal(SIGINT, stop_handler);
+			} else if (*argv[1]=='W') {
+				default_sweep_size=parseval(argv[1]+1);
+				if (default_sweep_size==0)
+					default_sweep_size=64*1024*1024;
+#if (MULTITHREAD>1)
+			} else if (*argv[1]=='M') {
+				default_num_contexts=parseval(argv[1]+1);
+				if (default_num_contexts>MULTITHREAD)
+					default_num_contexts=MULTITHREAD;
+			} else {
+				default_sweep_contexts=parseval(argv[1]+1);
+				if (default_sweep_contexts==0) {
+					long online=sysconf(_SC_NPROCESSORS_ONLN);
+					default_sweep_contexts=(online>0) ? (ee_u32)online : 1;
+				}
+				if (default_sweep_contexts>MULTITHREAD) {
+					ee_printf("WARNING! Sweep limited to %d contexts, rebuild with a larger MULTITHREAD\n",MULTITHREAD);
+					default_sweep_contexts=MULTITHREAD;
+				}
+				default_num_contexts=default_sweep_contexts;
+#endif
+			}
 			/* Shift args since first arg is directed to the portable part and not to coremark main */
 			--nargs;
 			for (i=1; i<nargs; i++)
@@ -216,7 +759,19 @@ void portable_init(core_portable *p, int *argc, char *argv[])
 			*argc=nargs;
 		}
 	}
-#endif /* sample of potential platform specific init via command line, reset the number of contexts being used if first argument is M<n>*/
+#endif /* sample of potential platform specific init via command line, reset the number of contexts being used if first argument is M<n>, sweep the number of contexts if it is S<n>, sweep the working set if it is W<n>, select the memory placement if it is P<name>, run continuously if it is C<n> */
+#if (MULTITHREAD>1) && USE_PTHREAD_POOL
+	pool_spawn(default_num_contexts);
+	if ((pool_size>0) && (pool_size<default_num_contexts)) {
+		ee_printf("ERROR! Only %u pool workers, running %u contexts\n", pool_size, pool_size);
+		default_num_contexts=pool_size;
+		if (default_sweep_contexts>pool_size)
+			default_sweep_contexts=pool_size;
+	}
+#elif (MULTITHREAD>1)
+	if (default_mem_policy==MEM_POLICY_LOCAL)
+		ee_printf("WARNING! Memory placement local needs the pinned workers of USE_PTHREAD_POOL, blocks are touched by the main thread\n");
+#endif
 	p->portable_id=1;
 }
 /* Function: portable_fini
@@ -224,6 +779,9 @@ void portable_init(core_portable *p, int *argc, char *argv[])
 */
 void portable_fini(core_portable *p)
 {
+#if (MULTITHREAD>1) && USE_PTHREAD_POOL
+	pool_shutdown();
+#endif
 	p->portable_id=0;
 }
 
@@ -236,76 +794,139 @@ void portable_fini(core_portable *p)
 /* Function: core_start_parallel
 	Start benchmarking in a parallel context.
 	
-	Three implementations are provided, one using pthreads, one using fork and shared mem, and one using fork and sockets.
+	Four implementations are provided, one using pthreads, one using a pool of pinned pthreads,
+	one using fork and shared mem, and one using fork and sockets.
 	Other implementations using MCAPI or other standards can easily be devised.
+
+	Returns:
+	1 if the context was started, 0 otherwise.
 */
 /* Function: core_stop_parallel
 	Stop a parallel context execution of coremark, and gather the results.
 	
-	Three implementations are provided, one using pthreads, one using fork and shared mem, and one using fork and sockets.
+	Four implementations are provided, one using pthreads, one using a pool of pinned pthreads,
+	one using fork and shared mem, and one using fork and sockets.
 	Other implementations using MCAPI or other standards can easily be devised.
 */
+#if USE_FORK || USE_SOCKET
+/* Define: RESULTS_XFER_SIZE
+	Size of the outputs of a context (CRCs, error count, time stamps and kernel counters) sent back by a child process.
+*/
+#define RESULTS_XFER_SIZE (offsetof(core_results, port) - offsetof(core_results, crc))
+#endif
+
 #if USE_PTHREAD
 ee_u8 core_start_parallel(core_results *res) {
-	return (ee_u8)pthread_create(&(res->port.thread),NULL,iterate,(void *)res);
+	return (ee_u8)(pthread_create(&(res->port.thread),NULL,iterate,(void *)res)==0);
 }
 ee_u8 core_stop_parallel(core_results *res) {
 	void *retval;
-	return (ee_u8)pthread_join(res->port.thread,&retval);
+	return (ee_u8)(pthread_join(res->port.thread,&retval)==0);
+}
+#elif USE_PTHREAD_POOL
+ee_u8 core_start_parallel(core_results *res) {
+	core_worker *w;
+	if (pool_busy==0) {
+		/* first context of a run, all its workers must exist before the start barrier
+		   is armed for them, or the ones started would wait in it forever */
+		pool_spawn(default_num_contexts);
+		if (pool_size<default_num_contexts) {
+			ee_printf("ERROR! Only %u of %u pool workers running\n", pool_size, default_num_contexts);
+			return 0;
+		}
+		if (pool_barrier_ready)
+			pthread_barrier_destroy(&pool_barrier);
+		pthread_barrier_init(&pool_barrier, NULL, default_num_contexts);
+		pool_barrier_ready=1;
+		pool_next=0;
+	}
+	if (pool_next>=default_num_contexts)
+		return 0;
+	w=&pool[pool_next];
+	res->port.worker=pool_next;
+	res->port.cpu=w->cpu;
+	w->res=res;
+	pool_next++;
+	pool_busy++;
+	sem_post(&w->go);
+	return 1;
+}
+ee_u8 core_stop_parallel(core_results *res) {
+	core_worker *w=&pool[res->port.worker];
+	while (sem_wait(&w->done)!=0)
+		;
+	pool_busy--;
+	return 1;
 }
 #elif USE_FORK
-static int key_id=0;
+/* The child copies its whole core_results to a shared anonymous mapping created before
+	the fork, the parent takes back the outputs. Nothing outlives the process, and there
+	is no key another run could collide with. */
 ee_u8 core_start_parallel(core_results *res) {
-	key_t key=4321+key_id;
-	key_id++;
-	res->port.pid=fork();
-	res->port.shmid=shmget(key, 8, IPC_CREAT | 0666);
-	if (res->port.shmid<0) {
-		ee_printf("ERROR in shmget!\n");
+	res->port.shm=mmap(NULL, sizeof(core_results), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if (res->port.shm==MAP_FAILED) {
+		ee_printf("ERROR in mmap: %s\n", strerror(errno));
+		res->port.shm=NULL;
+		return 0;
 	}
+	fflush(NULL); /* do not let the child flush our pending output again */
+	res->port.pid=fork();
 	if (res->port.pid==0) {
 		iterate(res);
-		res->port.shm=shmat(res->port.shmid, NULL, 0);
-		/* copy the validation values to the shared memory area  and quit*/
-		if (res->port.shm == (char *) -1) {
-			ee_printf("ERROR in child shmat!\n");
-		} else {
-			memcpy(res->port.shm,&(res->crc),8);
-			shmdt(res->port.shm);
-		}
+		memcpy(res->port.shm, res, sizeof(core_results));
 		exit(0);
 	}
+	if (res->port.pid<0) {
+		ee_printf("ERROR in fork: %s\n", strerror(errno));
+		munmap(res->port.shm, sizeof(core_results));
+		res->port.shm=NULL;
+		return 0;
+	}
 	return 1;
 }
 ee_u8 core_stop_parallel(core_results *res) {
 	int status;
-	pid_t wpid = waitpid(res->port.pid,&status,WUNTRACED);
-	if (wpid != res->port.pid) {
+	pid_t wpid;
+	if (res->port.shm==NULL)
+		return 0;
+	wpid = waitpid(res->port.pid,&status,WUNTRACED);
+	if ((wpid != res->port.pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
 		ee_printf("ERROR waiting for child.\n");
 		if (errno == ECHILD) ee_printf("errno=No such child %d\n",res->port.pid);
 		if (errno == EINTR) ee_printf("errno=Interrupted\n");
+		munmap(res->port.shm, sizeof(core_results));
+		res->port.shm=NULL;
 		return 0;
 	}
-	/* after process is done, get the values from the shared memory area */
-	res->port.shm=shmat(res->port.shmid, NULL, 0);
-	if (res->port.shm == (char *) -1) {
-		ee_printf("ERROR in parent shmat!\n");
-		return 0;
-	} 
-	memcpy(&(res->crc),res->port.shm,8);
-	shmdt(res->port.shm);
+	/* after process is done, take back its outputs, the inputs must stay those of the parent */
+	memcpy(&(res->crc),(char *)res->port.shm+offsetof(core_results, crc),RESULTS_XFER_SIZE);
+	munmap(res->port.shm, sizeof(core_results));
+	res->port.shm=NULL;
 	return 1;
 }
 #elif USE_SOCKET
-static int key_id=0;
+/* The parent binds port 0 on the loopback before the fork, so the kernel picks a free
+	port and the datagram of the child cannot arrive before the socket exists. */
 ee_u8 core_start_parallel(core_results *res) {
-	int bound, buffer_length=8;
+	int buffer_length=RESULTS_XFER_SIZE;
+	socklen_t salen=sizeof(res->port.sa);
+	memset(&(res->port.sa), 0, sizeof(res->port.sa));
 	res->port.sa.sin_family = AF_INET;
 	res->port.sa.sin_addr.s_addr = htonl(0x7F000001);
-	res->port.sa.sin_port = htons(7654+key_id);
-	key_id++;
+	res->port.sa.sin_port = 0;
+	res->port.sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if ((res->port.sock < 0)
+		|| (bind(res->port.sock,(struct sockaddr*)&(res->port.sa), sizeof(res->port.sa)) < 0)
+		|| (getsockname(res->port.sock,(struct sockaddr*)&(res->port.sa), &salen) < 0)) {
+		ee_printf("Error binding socket: %s\n",strerror(errno));
+		if (res->port.sock >= 0)
+			close(res->port.sock);
+		return 0;
+	}
+	fflush(NULL); /* do not let the child flush our pending output again */
 	res->port.pid=fork();
 	if (res->port.pid==0) { /* benchmark child */
+		close(res->port.sock);
 		iterate(res);
 		res->port.sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
 		if (-1 == res->port.sock) /* if socket failed to initialize, exit */   {
@@ -318,17 +939,13 @@ ee_u8 core_start_parallel(core_results *res) {
 		}
 		exit(0);
 	} 
-	/* parent process, open the socket */
-	res->port.sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	bound = bind(res->port.sock,(struct sockaddr*)&(res->port.sa), sizeof(struct sockaddr));
-	if (bound < 0)
-		ee_printf("bind(): %s\n",strerror(errno));
 	return 1;
 }
 ee_u8 core_stop_parallel(core_results *res) {
 	int status;
-	int fromlen=sizeof(struct sockaddr);
-	int recsize = recvfrom(res->port.sock, &(res->crc), 8, 0, (struct sockaddr*)&(res->port.sa), &fromlen);
+	socklen_t fromlen=sizeof(struct sockaddr);
+	int recsize = recvfrom(res->port.sock, &(res->crc), RESULTS_XFER_SIZE, 0, (struct sockaddr*)&(res->port.sa), &fromlen);
+	close(res->port.sock);
 	if (recsize < 0) {
 		ee_printf("Error in receive: %s\n", strerror(errno));
 		return 0;
@@ -19,6 +19,9 @@ Original Author: Shay Gal-on
 #include "coremark.h"
 /* local functions */
 enum CORE_STATE core_state_transition(ee_u8 **instr, ee_u32 *transition_count);
+#if CORE_STATE_TABLE
+static void state_run(ee_u8 *p, ee_u32 *final_counts, ee_u32 *track_counts);
+#endif
 
 /*
 Topic: Description
@@ -63,6 +66,9 @@ core_bench_state(ee_u32 blksize,
         final_counts[i] = track_counts[i] = 0;
     }
     /* run the state machine over the input */
+#if CORE_STATE_TABLE
+    state_run(p, final_counts, track_counts);
+#else
     while (*p != 0)
     {
         enum CORE_STATE fstate = core_state_transition(&p, track_counts);
@@ -73,6 +79,7 @@ core_bench_state(ee_u32 blksize,
     ee_printf("\n");
 #else
     }
+#endif
 #endif
     p = memblock;
     while (p < (memblock + blksize))
@@ -83,6 +90,9 @@ core_bench_state(ee_u32 blksize,
     }
     p = memblock;
     /* run the state machine over the input again */
+#if CORE_STATE_TABLE
+    state_run(p, final_counts, track_counts);
+#else
     while (*p != 0)
     {
         enum CORE_STATE fstate = core_state_transition(&p, track_counts);
@@ -93,6 +103,7 @@ core_bench_state(ee_u32 blksize,
     ee_printf("\n");
 #else
     }
+#endif
 #endif
     p = memblock;
     while (p < (memblock + blksize))
@@ -102,11 +113,25 @@ core_bench_state(ee_u32 blksize,
         p += step;
     }
     /* end timing */
+#if (CRC_METHOD == CRC_BITWISE)
     for (i = 0; i < NUM_CORE_STATES; i++)
     {
         crc = crcu32(final_counts[i], crc);
         crc = crcu32(track_counts[i], crc);
     }
+#else
+    { /* same byte order as the crcu32 calls, as one buffer for <crcbuf> */
+        ee_u8 counts[NUM_CORE_STATES * 8];
+        for (i = 0; i < NUM_CORE_STATES * 4; i++)
+        {
+            counts[i + (i & ~3u)]
+                = (ee_u8)(final_counts[i / 4] >> (8 * (i & 3)));
+            counts[i + (i & ~3u) + 4]
+                = (ee_u8)(track_counts[i / 4] >> (8 * (i & 3)));
+        }
+        crc = crcbuf(counts, sizeof(counts), crc);
+    }
+#endif
     return crc;
 }
 
@@ -328,3 +353,233 @@ core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
     *instr = str;
     return state;
 }
+
+#if CORE_STATE_TABLE
+/*
+Topic: Table driven state machine
+        With <CORE_STATE_TABLE> the same Moore machine is driven by two tables.
+   <state_class> maps every input byte to one of the classes below, and
+   <state_next> gives the next state for a state and class. <state_count>
+   gives the transition counters to increment as one 8b lane per state, so
+   every move is a single add into a register, flushed to the real counters
+   every few tokens.
+
+        The separators (',' and the terminating 0) are located ahead of the
+   machine by <state_scan>, 16 or 32 bytes at a time with SSE2 or AVX2, so the
+   machine runs over a token without testing for its end.
+
+        The counts are the same as <core_state_transition>, including its
+   corner cases: START counts INVALID too when it leaves to INVALID,
+   SCIENTIFIC counts only INVALID, and a token that ends INVALID does not
+   consume the following ','.
+*/
+#if defined(__GNUC__) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+#define CLASS_OTHER 0
+#define CLASS_DIGIT 1
+#define CLASS_SIGN  2
+#define CLASS_DOT   3
+#define CLASS_EXP   4
+#define NUM_CLASSES 5
+
+static const ee_u8 state_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x10 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 3, 0, /* 0x20 + - . */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, /* 0x30 0-9 */
+    0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x40 E */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x50 */
+    0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x60 e */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x70 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x80 - 0xff */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Next state for every state and class */
+static const ee_u8 state_next[NUM_CORE_STATES][NUM_CLASSES] = {
+    /* OTHER, DIGIT, SIGN, DOT, EXP */
+    { CORE_INVALID, CORE_INT, CORE_S1, CORE_FLOAT, CORE_INVALID }, /* START */
+    { CORE_INVALID, CORE_INVALID, CORE_INVALID, CORE_INVALID, CORE_INVALID },
+    { CORE_INVALID, CORE_INT, CORE_INVALID, CORE_FLOAT, CORE_INVALID }, /* S1 */
+    { CORE_INVALID,
+      CORE_INVALID,
+      CORE_EXPONENT,
+      CORE_INVALID,
+      CORE_INVALID }, /* S2 */
+    { CORE_INVALID, CORE_INT, CORE_INVALID, CORE_FLOAT, CORE_INVALID }, /* INT */
+    { CORE_INVALID,
+      CORE_FLOAT,
+      CORE_INVALID,
+      CORE_INVALID,
+      CORE_S2 }, /* FLOAT */
+    { CORE_INVALID,
+      CORE_SCIENTIFIC,
+      CORE_INVALID,
+      CORE_INVALID,
+      CORE_INVALID }, /* EXPONENT */
+    { CORE_INVALID,
+      CORE_SCIENTIFIC,
+      CORE_INVALID,
+      CORE_INVALID,
+      CORE_INVALID } /* SCIENTIFIC */
+};
+
+/* Transition counters to increment for every state and class */
+#define COUNT(s) (1ULL << (8 * (s)))
+static const unsigned long long state_count[NUM_CORE_STATES][NUM_CLASSES] = {
+    { COUNT(CORE_START) | COUNT(CORE_INVALID),
+      COUNT(CORE_START),
+      COUNT(CORE_START),
+      COUNT(CORE_START),
+      COUNT(CORE_START) | COUNT(CORE_INVALID) },
+    { 0, 0, 0, 0, 0 }, /* INVALID, never entered */
+    { COUNT(CORE_S1),
+      COUNT(CORE_S1),
+      COUNT(CORE_S1),
+      COUNT(CORE_S1),
+      COUNT(CORE_S1) },
+    { COUNT(CORE_S2),
+      COUNT(CORE_S2),
+      COUNT(CORE_S2),
+      COUNT(CORE_S2),
+      COUNT(CORE_S2) },
+    { COUNT(CORE_INT), 0, COUNT(CORE_INT), COUNT(CORE_INT), COUNT(CORE_INT) },
+    { COUNT(CORE_FLOAT),
+      0,
+      COUNT(CORE_FLOAT),
+      COUNT(CORE_FLOAT),
+      COUNT(CORE_FLOAT) },
+    { COUNT(CORE_EXPONENT),
+      COUNT(CORE_EXPONENT),
+      COUNT(CORE_EXPONENT),
+      COUNT(CORE_EXPONENT),
+      COUNT(CORE_EXPONENT) },
+    { COUNT(CORE_INVALID),
+      0,
+      COUNT(CORE_INVALID),
+      COUNT(CORE_INVALID),
+      COUNT(CORE_INVALID) }
+};
+/* a token counts at most once per lane, so 32 tokens cannot overflow one */
+#define TOKENS_PER_FLUSH 32
+
+/* Function: state_scan
+        Return the first ',' or 0 at or after <p>.
+
+        The vector versions only use aligned loads, which cannot cross into
+   the next page, so reading past the terminating 0 is harmless.
+*/
+static ee_u8 *
+state_scan(ee_u8 *p)
+{
+#if defined(__GNUC__) && defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i zero  = _mm256_setzero_si256();
+    ee_u8 *       base  = (ee_u8 *)((ee_ptr_int)p & ~(ee_ptr_int)31);
+    __m256i       v     = _mm256_load_si256((const __m256i *)base);
+    ee_u32        mask  = (ee_u32)_mm256_movemask_epi8(
+                       _mm256_or_si256(_mm256_cmpeq_epi8(v, comma),
+                                       _mm256_cmpeq_epi8(v, zero)))
+                  & (0xffffffffu << (p - base));
+    while (mask == 0)
+    {
+        base += 32;
+        v    = _mm256_load_si256((const __m256i *)base);
+        mask = (ee_u32)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, zero)));
+    }
+    return base + __builtin_ctz(mask);
+#elif defined(__GNUC__) && defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i zero  = _mm_setzero_si128();
+    ee_u8 *       base  = (ee_u8 *)((ee_ptr_int)p & ~(ee_ptr_int)15);
+    __m128i       v     = _mm_load_si128((const __m128i *)base);
+    ee_u32        mask  = (ee_u32)_mm_movemask_epi8(_mm_or_si128(
+                       _mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, zero)))
+                  & (0xffffu << (p - base));
+    while (mask == 0)
+    {
+        base += 16;
+        v    = _mm_load_si128((const __m128i *)base);
+        mask = (ee_u32)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, zero)));
+    }
+    return base + __builtin_ctz(mask);
+#else
+    while ((*p != 0) && (*p != ','))
+        p++;
+    return p;
+#endif
+}
+
+/* Function: state_token
+        Run the machine from <*instr> up to at most the separator at <stop>.
+   Same result and same update of <*instr> as <core_state_transition>, the
+   transitions are added to the lanes of <counts>.
+*/
+static enum CORE_STATE
+state_token(ee_u8 **instr, ee_u8 *stop, unsigned long long *counts)
+{
+    ee_u8 *            str   = *instr;
+    ee_u8              state = CORE_START;
+    unsigned long long c     = *counts;
+    while (str < stop)
+    {
+        ee_u8 cls = state_class[*str++];
+        c += state_count[state][cls];
+        state = state_next[state][cls];
+        if (state == CORE_INVALID)
+            break;
+    }
+    if ((state != CORE_INVALID) && (*str == ',')) /* end of this input */
+        str++;
+    *instr  = str;
+    *counts = c;
+    return (enum CORE_STATE)state;
+}
+
+/* Function: state_run
+        Run the machine over all tokens of the input, as the loop in
+   <core_bench_state> does with <core_state_transition>.
+
+        A token that ends INVALID leaves the rest of the token to be scanned as
+   new tokens, up to the same separator, which is then reused.
+*/
+static void
+state_run(ee_u8 *p, ee_u32 *final_counts, ee_u32 *track_counts)
+{
+    unsigned long long counts = 0;
+    ee_u8 *            stop   = state_scan(p);
+    ee_u32             tokens = 0, i;
+    while (*p != 0)
+    {
+        enum CORE_STATE fstate;
+        if (p > stop)
+            stop = state_scan(p);
+        fstate = state_token(&p, stop, &counts);
+        final_counts[fstate]++;
+#if CORE_DEBUG
+        ee_printf("%d,", fstate);
+#endif
+        if (++tokens == TOKENS_PER_FLUSH)
+        {
+            for (i = 0; i < NUM_CORE_STATES; i++)
+                track_counts[i] += (ee_u32)(counts >> (8 * i)) & 0xff;
+            counts = tokens = 0;
+        }
+    }
+#if CORE_DEBUG
+    ee_printf("\n");
+#endif
+    for (i = 0; i < NUM_CORE_STATES; i++)
+        track_counts[i] += (ee_u32)(counts >> (8 * i)) & 0xff;
+}
+#endif /* CORE_STATE_TABLE */
@@ -344,6 +344,28 @@
  ***************************************************************************
  */
 
+#if !defined(NOFORK) && (defined(__unix__) || defined(__APPLE__))
+#define FORK_COPIES
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+                /* for sched_setaffinity */
+#endif
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+                /* Usage: dhrystone <runs> <copies> <repetitions>         */
+                /* <runs> 0 calibrates the runs to last DHRY_SECS.        */
+                /* <copies> runs independent copies of the benchmark as   */
+                /* forked processes, each with its own globals and pinned */
+                /* to one CPU on Linux, released together; 0 runs one per */
+                /* online CPU. Define NOFORK where fork is not available. */
+                /* <repetitions> repeats the measurement and reports the  */
+                /* median and the range of the results.                   */
+
 /* General definitions: */
 #include <stdlib.h>
                 /* for exit */
@@ -362,7 +384,7 @@
 #endif
 #endif
 
-#ifndef TIME
+#if !defined(TIME) && !defined(MONOTONIC)
 #undef TIMES
 #define TIMES
 #endif
@@ -377,6 +399,27 @@
 #endif
 		/* Use Microsoft C hi-res clock */
 
+#ifdef MONOTONIC
+#undef HZ
+#undef TIMES
+#include <time.h>
+#define HZ	1000000
+typedef long long Time_Type;
+#else
+typedef long Time_Type;
+#endif
+		/* Use clock_gettime(CLOCK_MONOTONIC), in microseconds,  */
+		/* which overflow a 32 bit long within an hour of uptime */
+
+#ifndef DHRY_SECS
+#define DHRY_SECS 3
+#endif
+                /* Target duration of one measurement when the number   */
+                /* of runs is calibrated, i.e. given as 0               */
+
+#define MAX_REPS 100
+                /* Most repetitions of the measurement that are kept    */
+
 #ifndef HZ
 #define HZ DHRY_HZ
 #endif
@@ -451,6 +494,30 @@ typedef struct record
           } variant;
       } Rec_Type, *Rec_Pointer;
 
+typedef struct
+    {
+    One_Fifty      Int_1_Loc;
+    One_Fifty      Int_2_Loc;
+    One_Fifty      Int_3_Loc;
+    Enumeration    Enum_Loc;
+    Str_30         Str_1_Loc;
+    Str_30         Str_2_Loc;
+    } Loc_Type;
+                /* Final values of the locals of Proc_0, to report them */
+
+#ifdef FORK_COPIES
+typedef struct
+    {
+    int            Cpu;
+                /* CPU the copy was pinned to, -1 if not pinned */
+    Time_Type      User_Time [MAX_REPS];
+    int            Wrong;
+                /* final values that were wrong */
+    int            Done;
+    } Copy_Type;
+                /* Result of a copy, in memory shared with the parent */
+#endif
+
 /* ANSI Function Prototypes */
 void Proc_2 (One_Fifty *Int_Par_Ref);
 void Proc_3 (Rec_Pointer *Ptr_Ref_Par);
@@ -61,6 +61,16 @@ extern long     time();
 extern clock_t	clock();
 #define Too_Small_Time (2*HZ)
 #endif
+#ifdef MONOTONIC
+struct timespec time_info;
+                /* see library function "clock_gettime" */
+#define Too_Small_Time (2*HZ)
+#endif
+#ifdef TIME
+#define Target_Time DHRY_SECS
+#else
+#define Target_Time (DHRY_SECS*HZ)
+#endif
 
 #ifndef FLOAT
 	Boolean Float_Rating = false;
@@ -68,7 +78,7 @@ extern clock_t	clock();
 	Boolean Float_Rating = true;
 #endif
 
-long            Begin_Time,
+Time_Type       Begin_Time,
                 End_Time,
                 User_Time;
 measure         Microseconds,
@@ -79,22 +89,29 @@ measure         Microseconds,
 /* ANSI function prototypes */
 Enumeration Func_1 (Capital_Letter Ch_1_Par_Val, Capital_Letter Ch_2_Par_Val);
 void Proc_1 (REG Rec_Pointer Ptr_Val_Par);
+void Proc_0 (int Number_Of_Runs, Loc_Type *Loc);
+measure Dhrystones_Rate (Time_Type User_Time, int Number_Of_Runs);
+int Calibrate_Runs (void);
+int Check_Final (unsigned Total_Runs, Loc_Type *Loc);
+measure Print_Stats (measure Rate [], int Number_Of_Reps);
+#ifdef FORK_COPIES
+int Run_Copies (int Number_Of_Runs, int Number_Of_Copies,
+                int Number_Of_Reps);
+#endif
 
 int main (int argc, char **argv)
 /*****/
 
-  /* main program, corresponds to procedures        */
-  /* Main and Proc_0 in the Ada version             */
+  /* main program, corresponds to procedure Main in the Ada version */
 {
-        One_Fifty       Int_1_Loc;
-  REG   One_Fifty       Int_2_Loc;
-        One_Fifty       Int_3_Loc;
-  REG   char            Ch_Index;
-        Enumeration     Enum_Loc;
-        Str_30          Str_1_Loc;
-        Str_30          Str_2_Loc;
-  REG   int             Run_Index;
-  REG   int             Number_Of_Runs;
+        Loc_Type        Loc;
+        int             Number_Of_Runs;
+        int             Number_Of_Copies = 1;
+        int             Number_Of_Reps = 1;
+        int             Rep_Index;
+        int             Wrong;
+        Time_Type       Rep_Time [MAX_REPS];
+        measure         Rate [MAX_REPS];
 
   /* Initializations */
 
@@ -107,7 +124,6 @@ int main (int argc, char **argv)
   Ptr_Glob->variant.var_1.Int_Comp      = 40;
   strcpy (Ptr_Glob->variant.var_1.Str_Comp, 
           "DHRYSTONE PROGRAM, SOME STRING");
-  strcpy (Str_1_Loc, "DHRYSTONE PROGRAM, 1'ST STRING");
 
   Arr_2_Glob [8][7] = 10;
         /* Was missing in published program. Without this statement,    */
@@ -127,11 +143,11 @@ int main (int argc, char **argv)
   }
   if (Float_Rating)
   {
-    printf ("Ratings using 'float' datatype (%d bytes)\n",sizeof(float));
+    printf ("Ratings using 'float' datatype (%d bytes)\n",(int) sizeof(float));
   }
   else
   {
-    printf ("Ratings using 'double' datatype (%d bytes)\n",sizeof(double));
+    printf ("Ratings using 'double' datatype (%d bytes)\n",(int) sizeof(double));
   }
   printf ("HZ = %d\n", HZ);
   printf ("\n");
@@ -146,7 +162,274 @@ int main (int argc, char **argv)
   } else {
 	Number_Of_Runs = atoi(argv[1]);
   }
-  printf ("Execution starts, %d runs through Dhrystone\n", Number_Of_Runs);
+  if (argc >= 3)
+  {
+    Number_Of_Copies = atoi (argv[2]);
+        /* 0 runs one copy per CPU the process may run on */
+  }
+  if (argc >= 4)
+  {
+    Number_Of_Reps = atoi (argv[3]);
+    if (Number_Of_Reps < 1)
+      Number_Of_Reps = 1;
+    if (Number_Of_Reps > MAX_REPS)
+      Number_Of_Reps = MAX_REPS;
+  }
+  if (Number_Of_Runs <= 0)
+  {
+    Number_Of_Runs = Calibrate_Runs ();
+  }
+#ifdef FORK_COPIES
+  if (Number_Of_Copies != 1)
+  {
+    return Run_Copies (Number_Of_Runs, Number_Of_Copies, Number_Of_Reps);
+  }
+#else
+  if (Number_Of_Copies != 1)
+  {
+    printf ("Multiple copies need fork, running one copy\n");
+  }
+#endif
+  printf ("Execution starts, %d runs through Dhrystone", Number_Of_Runs);
+  if (Number_Of_Reps > 1)
+    printf (", %d times", Number_Of_Reps);
+  printf ("\n");
+
+  for (Rep_Index = 0; Rep_Index < Number_Of_Reps; ++Rep_Index)
+  {
+    Proc_0 (Number_Of_Runs, &Loc);
+    Rep_Time [Rep_Index] = End_Time - Begin_Time;
+  }
+
+  printf ("Execution ends\n");
+  printf ("\n");
+  printf ("Final values of the variables used in the benchmark:\n");
+  printf ("\n");
+  printf ("Int_Glob:            %d\n", Int_Glob);
+  printf ("        should be:   %d\n", 5);
+  printf ("Bool_Glob:           %d\n", Bool_Glob);
+  printf ("        should be:   %d\n", 1);
+  printf ("Ch_1_Glob:           %c\n", Ch_1_Glob);
+  printf ("        should be:   %c\n", 'A');
+  printf ("Ch_2_Glob:           %c\n", Ch_2_Glob);
+  printf ("        should be:   %c\n", 'B');
+  printf ("Arr_1_Glob[8]:       %d\n", Arr_1_Glob[8]);
+  printf ("        should be:   %d\n", 7);
+  printf ("Arr_2_Glob[8][7]:    %d\n", Arr_2_Glob[8][7]);
+  if (Number_Of_Reps > 1)
+    printf ("        should be:   Number_Of_Runs * repetitions + 10\n");
+  else
+    printf ("        should be:   Number_Of_Runs + 10\n");
+  printf ("Ptr_Glob->\n");
+  printf ("  Discr:             %d\n", Ptr_Glob->Discr);
+  printf ("        should be:   %d\n", 0);
+  printf ("  Enum_Comp:         %d\n", Ptr_Glob->variant.var_1.Enum_Comp);
+  printf ("        should be:   %d\n", 2);
+  printf ("  Int_Comp:          %d\n", Ptr_Glob->variant.var_1.Int_Comp);
+  printf ("        should be:   %d\n", 17);
+  printf ("  Str_Comp:          %s\n", Ptr_Glob->variant.var_1.Str_Comp);
+  printf ("        should be:   DHRYSTONE PROGRAM, SOME STRING\n");
+  printf ("Next_Ptr_Glob->\n");
+  printf ("  Discr:             %d\n", Next_Ptr_Glob->Discr);
+  printf ("        should be:   %d\n", 0);
+  printf ("  Enum_Comp:         %d\n", Next_Ptr_Glob->variant.var_1.Enum_Comp);
+  printf ("        should be:   %d\n", 1);
+  printf ("  Int_Comp:          %d\n", Next_Ptr_Glob->variant.var_1.Int_Comp);
+  printf ("        should be:   %d\n", 18);
+  printf ("  Str_Comp:          %s\n",
+                                Next_Ptr_Glob->variant.var_1.Str_Comp);
+  printf ("        should be:   DHRYSTONE PROGRAM, SOME STRING\n");
+  printf ("Int_1_Loc:           %d\n", Loc.Int_1_Loc);
+  printf ("        should be:   %d\n", 5);
+  printf ("Int_2_Loc:           %d\n", Loc.Int_2_Loc);
+  printf ("        should be:   %d\n", 13);
+  printf ("Int_3_Loc:           %d\n", Loc.Int_3_Loc);
+  printf ("        should be:   %d\n", 7);
+  printf ("Enum_Loc:            %d\n", Loc.Enum_Loc);
+  printf ("        should be:   %d\n", 1);
+  printf ("Str_1_Loc:           %s\n", Loc.Str_1_Loc);
+  printf ("        should be:   DHRYSTONE PROGRAM, 1'ST STRING\n");
+  printf ("Str_2_Loc:           %s\n", Loc.Str_2_Loc);
+  printf ("        should be:   DHRYSTONE PROGRAM, 2'ND STRING\n");
+  printf ("\n");
+  Wrong = Check_Final ((unsigned) Number_Of_Runs * Number_Of_Reps, &Loc);
+  if (Wrong)
+  {
+    printf ("Final values: %d wrong, the results are not valid\n", Wrong);
+  }
+  else
+  {
+    printf ("Final values: all correct\n");
+  }
+  printf ("\n");
+
+  User_Time = Rep_Time [0];
+  for (Rep_Index = 1; Rep_Index < Number_Of_Reps; ++Rep_Index)
+    if (Rep_Time [Rep_Index] < User_Time)
+      User_Time = Rep_Time [Rep_Index];
+
+  if (User_Time < Too_Small_Time)
+  {
+    printf ("Measured time too small to obtain meaningful results\n");
+    printf ("Please increase number of runs\n");
+    printf ("\n");
+  }
+  else
+  {
+    for (Rep_Index = 0; Rep_Index < Number_Of_Reps; ++Rep_Index)
+      Rate [Rep_Index] = Dhrystones_Rate (Rep_Time [Rep_Index], Number_Of_Runs);
+    Dhrystones_Per_Second = Print_Stats (Rate, Number_Of_Reps);
+        /* the median of the repetitions */
+    Microseconds = Mic_secs_Per_Second / Dhrystones_Per_Second;
+    printf ("Microseconds for one run through Dhrystone: ");
+    printf ("%12.1f \n", Microseconds);
+    printf ("Dhrystones per Second:                      ");
+    printf ("%12.1f \n", Dhrystones_Per_Second);
+    printf ("VAX MIPS:                                   ");
+    printf ("%12.1f \n", Dhrystones_Per_Second/1757);
+    printf ("DMIPS:                                      ");
+    printf ("%12.1f \n", Dhrystones_Per_Second/1757);
+    printf ("\n");
+  }
+  return Wrong ? 1 : 0;
+}
+
+
+int Check_Final (unsigned Total_Runs, Loc_Type *Loc)
+/******************/
+    /* compares the final values of the variables with what they should */
+    /* be after Total_Runs runs, so that a build which does not run the */
+    /* benchmark correctly cannot pass for a fast one                   */
+    /* returns the number of wrong values                               */
+{
+  int             Wrong = 0;
+
+  Wrong += Int_Glob != 5;
+  Wrong += Bool_Glob != 1;
+  Wrong += Ch_1_Glob != 'A';
+  Wrong += Ch_2_Glob != 'B';
+  Wrong += Arr_1_Glob[8] != 7;
+  Wrong += (unsigned) Arr_2_Glob[8][7] != Total_Runs + 10;
+  Wrong += Ptr_Glob->Ptr_Comp != Next_Ptr_Glob;
+  Wrong += Ptr_Glob->Discr != Ident_1;
+  Wrong += Ptr_Glob->variant.var_1.Enum_Comp != Ident_3;
+  Wrong += Ptr_Glob->variant.var_1.Int_Comp != 17;
+  Wrong += strcmp (Ptr_Glob->variant.var_1.Str_Comp,
+                   "DHRYSTONE PROGRAM, SOME STRING") != 0;
+  Wrong += Next_Ptr_Glob->Ptr_Comp != Next_Ptr_Glob;
+  Wrong += Next_Ptr_Glob->Discr != Ident_1;
+  Wrong += Next_Ptr_Glob->variant.var_1.Enum_Comp != Ident_2;
+  Wrong += Next_Ptr_Glob->variant.var_1.Int_Comp != 18;
+  Wrong += strcmp (Next_Ptr_Glob->variant.var_1.Str_Comp,
+                   "DHRYSTONE PROGRAM, SOME STRING") != 0;
+  Wrong += Loc->Int_1_Loc != 5;
+  Wrong += Loc->Int_2_Loc != 13;
+  Wrong += Loc->Int_3_Loc != 7;
+  Wrong += Loc->Enum_Loc != Ident_2;
+  Wrong += strcmp (Loc->Str_1_Loc, "DHRYSTONE PROGRAM, 1'ST STRING") != 0;
+  Wrong += strcmp (Loc->Str_2_Loc, "DHRYSTONE PROGRAM, 2'ND STRING") != 0;
+  return Wrong;
+} /* Check_Final */
+
+
+int Calibrate_Runs (void)
+/******************/
+    /* grows the number of runs until one measurement lasts Target_Time */
+{
+  Loc_Type        Loc;
+  Time_Type       Time;
+  double          Runs = 1000;
+
+  printf ("Calibrating the number of runs for %d seconds\n", DHRY_SECS);
+  for (;;)
+  {
+    Proc_0 ((int) Runs, &Loc);
+    Time = End_Time - Begin_Time;
+    if (Time >= Target_Time)
+      break;
+    if ((Time <= 0) || (Time < Target_Time / 10))
+      Runs *= 10;
+        /* also for a time below the resolution of the timer */
+    else
+      Runs *= 1.1 * (double) Target_Time / (double) Time;
+    if (Runs >= 0x7fffffff)
+    {
+      Runs = 0x7fffffff;
+      break;
+    }
+  }
+  Arr_2_Glob [8][7] = 10;
+        /* as if the calibration had not run */
+  return (int) Runs;
+} /* Calibrate_Runs */
+
+
+measure Print_Stats (measure Rate [], int Number_Of_Reps)
+/******************/
+    /* prints the range of the Dhrystones per second of the repetitions */
+    /* returns their median                                              */
+{
+  measure         Sorted [MAX_REPS] = { 0 },
+                  Median,
+                  Mean = 0;
+  int             Index,
+                  Next;
+
+  for (Index = 0; Index < Number_Of_Reps; ++Index)
+  {
+    for (Next = Index; (Next > 0) && (Sorted [Next - 1] > Rate [Index]); --Next)
+      Sorted [Next] = Sorted [Next - 1];
+    Sorted [Next] = Rate [Index];
+    Mean += Rate [Index];
+  }
+  Mean /= Number_Of_Reps;
+  if (Number_Of_Reps % 2)
+    Median = Sorted [Number_Of_Reps / 2];
+  else
+    Median = (Sorted [Number_Of_Reps / 2 - 1] + Sorted [Number_Of_Reps / 2]) / 2;
+  if (Number_Of_Reps > 1)
+  {
+    printf ("DMIPS of %d repetitions:\n", Number_Of_Reps);
+    printf ("  min %.1f  median %.1f  mean %.1f  max %.1f  spread %.2f%%\n",
+            Sorted [0] / 1757, Median / 1757, Mean / 1757,
+            Sorted [Number_Of_Reps - 1] / 1757,
+            100 * (Sorted [Number_Of_Reps - 1] - Sorted [0]) / Median);
+    printf ("\n");
+  }
+  return Median;
+} /* Print_Stats */
+
+
+measure Dhrystones_Rate (Time_Type User_Time, int Number_Of_Runs)
+/******************************************************/
+    /* Dhrystones per second for a measured time in the units of the timer */
+{
+#ifdef TIME
+  return (measure) Number_Of_Runs / (measure) User_Time;
+#else
+  return ((measure) HZ * (measure) Number_Of_Runs) / (measure) User_Time;
+#endif
+} /* Dhrystones_Rate */
+
+
+void Proc_0 (int Number_Of_Runs, Loc_Type *Loc)
+/******************/
+    /* the measurement, corresponds to procedure Proc_0 in the Ada version */
+    /* sets Begin_Time and End_Time, and the final values of its locals   */
+{
+        One_Fifty       Int_1_Loc;
+  REG   One_Fifty       Int_2_Loc;
+        One_Fifty       Int_3_Loc;
+  REG   char            Ch_Index;
+        Enumeration     Enum_Loc;
+        Str_30          Str_1_Loc;
+        Str_30          Str_2_Loc;
+  REG   int             Run_Index;
+
+  strcpy (Str_1_Loc, "DHRYSTONE PROGRAM, 1'ST STRING");
+  Int_1_Loc = 0;
+  Int_2_Loc = 0;
+        /* for 0 runs */
 
   /***************/
   /* Start timer */
@@ -162,6 +445,10 @@ int main (int argc, char **argv)
 #ifdef MSC_CLOCK
   Begin_Time = clock();
 #endif
+#ifdef MONOTONIC
+  clock_gettime (CLOCK_MONOTONIC, &time_info);
+  Begin_Time = (Time_Type) time_info.tv_sec * HZ + time_info.tv_nsec / 1000;
+#endif
 
   for (Run_Index = 1; Run_Index <= Number_Of_Runs; ++Run_Index)
   {
@@ -223,86 +510,202 @@ int main (int argc, char **argv)
 #ifdef MSC_CLOCK
   End_Time = clock();
 #endif
+#ifdef MONOTONIC
+  clock_gettime (CLOCK_MONOTONIC, &time_info);
+  End_Time = (Time_Type) time_info.tv_sec * HZ + time_info.tv_nsec / 1000;
+#endif
 
-  printf ("Execution ends\n");
+  Loc->Int_1_Loc = Int_1_Loc;
+  Loc->Int_2_Loc = Int_2_Loc;
+  Loc->Int_3_Loc = Int_3_Loc;
+  Loc->Enum_Loc = Enum_Loc;
+  strcpy (Loc->Str_1_Loc, Str_1_Loc);
+  strcpy (Loc->Str_2_Loc, Str_2_Loc);
+} /* Proc_0 */
+
+
+#ifdef FORK_COPIES
+int Run_Copies (int Number_Of_Runs, int Number_Of_Copies, int Number_Of_Reps)
+/******************/
+    /* runs Number_Of_Copies independent copies of Proc_0 in forked     */
+    /* processes, released together, and reports their sum and each one */
+    /* returns the exit code of the program                             */
+{
+  long            Online = sysconf (_SC_NPROCESSORS_ONLN);
+  volatile int   *Go;
+  Copy_Type      *Copy;
+  Loc_Type        Loc;
+  measure         Rate [MAX_REPS],
+                  Sum [MAX_REPS];
+  int             Copy_Index,
+                  Rep_Index,
+                  Ready,
+                  Wrong = 0,
+                  Errors = 0;
+  pid_t           Pid;
+#ifdef __linux__
+  cpu_set_t       Allowed;
+  int             Cpus [CPU_SETSIZE],
+                  Number_Of_Cpus = 0,
+                  Cpu;
+
+  if (sched_getaffinity (0, sizeof (Allowed), &Allowed) == 0)
+    /* the CPUs left by taskset or the cpuset, in order */
+    for (Cpu = 0; Cpu < CPU_SETSIZE; ++Cpu)
+      if (CPU_ISSET (Cpu, &Allowed))
+        Cpus [Number_Of_Cpus++] = Cpu;
+  if (Number_Of_Cpus > 0)
+    Online = Number_Of_Cpus;
+#endif
+  if (Online < 1)
+    Online = 1;
+  if (Number_Of_Copies <= 0)
+    Number_Of_Copies = (int) Online;
+  Go = (volatile int *) mmap (Null, sizeof (int)
+                              + Number_Of_Copies * sizeof (Copy_Type),
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if ((void *) Go == MAP_FAILED)
+  {
+    printf ("Cannot map the results of the copies\n");
+    return 1;
+  }
+  Copy = (Copy_Type *) (Go + 1);
+        /* anonymous shared memory starts zeroed: nothing done, no go */
+
+  printf ("Execution starts, %d runs through Dhrystone in each of %d copies",
+          Number_Of_Runs, Number_Of_Copies);
+  if (Number_Of_Reps > 1)
+    printf (", %d times", Number_Of_Reps);
   printf ("\n");
-  printf ("Final values of the variables used in the benchmark:\n");
+  fflush (stdout);
+        /* do not let the copies flush pending output again */
+  for (Copy_Index = 0; Copy_Index < Number_Of_Copies; ++Copy_Index)
+  {
+    Copy[Copy_Index].Cpu = -1;
+    Pid = fork ();
+    if (Pid < 0)
+    {
+      printf ("Cannot fork copy %d\n", Copy_Index);
+      *Go = -1;
+      break;
+    }
+    if (Pid == 0)
+      /* copy, with its own globals */
+    {
+#ifdef __linux__
+      cpu_set_t   Mask;
+      if (Number_Of_Cpus > 0)
+      {
+        CPU_ZERO (&Mask);
+        CPU_SET (Cpus [Copy_Index % Number_Of_Cpus], &Mask);
+        if (sched_setaffinity (0, sizeof (Mask), &Mask) == 0)
+          Copy[Copy_Index].Cpu = Cpus [Copy_Index % Number_Of_Cpus];
+      }
+#endif
+      __sync_fetch_and_add (&Copy[Copy_Index].Done, 1);
+        /* ready */
+      while (*Go == 0)
+        sched_yield ();
+      if (*Go > 0)
+      {
+        for (Rep_Index = 0; Rep_Index < Number_Of_Reps; ++Rep_Index)
+        {
+          Proc_0 (Number_Of_Runs, &Loc);
+          Copy[Copy_Index].User_Time [Rep_Index] = End_Time - Begin_Time;
+        }
+        Copy[Copy_Index].Wrong = Check_Final ((unsigned) Number_Of_Runs
+                                              * Number_Of_Reps, &Loc);
+        __sync_fetch_and_add (&Copy[Copy_Index].Done, 1);
+      }
+      _exit (0);
+    }
+  }
+  if (*Go == 0)
+  {
+    do
+      /* release the copies together once all are pinned */
+    {
+      Ready = 0;
+      for (Copy_Index = 0; Copy_Index < Number_Of_Copies; ++Copy_Index)
+        Ready += Copy[Copy_Index].Done > 0;
+      if (Ready < Number_Of_Copies)
+        sched_yield ();
+    } while (Ready < Number_Of_Copies);
+    __sync_synchronize ();
+    *Go = 1;
+  }
+  while (wait (Null) > 0)
+    ;
+  printf ("Execution ends\n");
   printf ("\n");
-  printf ("Int_Glob:            %d\n", Int_Glob);
-  printf ("        should be:   %d\n", 5);
-  printf ("Bool_Glob:           %d\n", Bool_Glob);
-  printf ("        should be:   %d\n", 1);
-  printf ("Ch_1_Glob:           %c\n", Ch_1_Glob);
-  printf ("        should be:   %c\n", 'A');
-  printf ("Ch_2_Glob:           %c\n", Ch_2_Glob);
-  printf ("        should be:   %c\n", 'B');
-  printf ("Arr_1_Glob[8]:       %d\n", Arr_1_Glob[8]);
-  printf ("        should be:   %d\n", 7);
-  printf ("Arr_2_Glob[8][7]:    %d\n", Arr_2_Glob[8][7]);
-  printf ("        should be:   Number_Of_Runs + 10\n");
-  printf ("Ptr_Glob->\n");
-  printf ("  Discr:             %d\n", Ptr_Glob->Discr);
-  printf ("        should be:   %d\n", 0);
-  printf ("  Enum_Comp:         %d\n", Ptr_Glob->variant.var_1.Enum_Comp);
-  printf ("        should be:   %d\n", 2);
-  printf ("  Int_Comp:          %d\n", Ptr_Glob->variant.var_1.Int_Comp);
-  printf ("        should be:   %d\n", 17);
-  printf ("  Str_Comp:          %s\n", Ptr_Glob->variant.var_1.Str_Comp);
-  printf ("        should be:   DHRYSTONE PROGRAM, SOME STRING\n");
-  printf ("Next_Ptr_Glob->\n");
-  printf ("  Discr:             %d\n", Next_Ptr_Glob->Discr);
-  printf ("        should be:   %d\n", 0);
-  printf ("  Enum_Comp:         %d\n", Next_Ptr_Glob->variant.var_1.Enum_Comp);
-  printf ("        should be:   %d\n", 1);
-  printf ("  Int_Comp:          %d\n", Next_Ptr_Glob->variant.var_1.Int_Comp);
-  printf ("        should be:   %d\n", 18);
-  printf ("  Str_Comp:          %s\n",
-                                Next_Ptr_Glob->variant.var_1.Str_Comp);
-  printf ("        should be:   DHRYSTONE PROGRAM, SOME STRING\n");
-  printf ("Int_1_Loc:           %d\n", Int_1_Loc);
-  printf ("        should be:   %d\n", 5);
-  printf ("Int_2_Loc:           %d\n", Int_2_Loc);
-  printf ("        should be:   %d\n", 13);
-  printf ("Int_3_Loc:           %d\n", Int_3_Loc);
-  printf ("        should be:   %d\n", 7);
-  printf ("Enum_Loc:            %d\n", Enum_Loc);
-  printf ("        should be:   %d\n", 1);
-  printf ("Str_1_Loc:           %s\n", Str_1_Loc);
-  printf ("        should be:   DHRYSTONE PROGRAM, 1'ST STRING\n");
-  printf ("Str_2_Loc:           %s\n", Str_2_Loc);
-  printf ("        should be:   DHRYSTONE PROGRAM, 2'ND STRING\n");
+  for (Rep_Index = 0; Rep_Index < Number_Of_Reps; ++Rep_Index)
+    Sum [Rep_Index] = 0;
+  printf ("Copy   CPU  Dhrystones per Second        DMIPS\n");
+  for (Copy_Index = 0; Copy_Index < Number_Of_Copies; ++Copy_Index)
+  {
+    if (Copy[Copy_Index].Done != 2)
+    {
+      printf ("%4d  failed\n", Copy_Index);
+      ++Errors;
+      continue;
+    }
+    if (Copy[Copy_Index].Wrong)
+    {
+      printf ("%4d %5d  %d final values wrong, the results are not valid\n",
+              Copy_Index, Copy[Copy_Index].Cpu, Copy[Copy_Index].Wrong);
+      ++Errors;
+      ++Wrong;
+      continue;
+    }
+    for (Rep_Index = 0; Rep_Index < Number_Of_Reps; ++Rep_Index)
+    {
+      if (Copy[Copy_Index].User_Time [Rep_Index] < Too_Small_Time)
+        break;
+      Rate [Rep_Index] = Dhrystones_Rate (Copy[Copy_Index].User_Time [Rep_Index],
+                                          Number_Of_Runs);
+      Sum [Rep_Index] += Rate [Rep_Index];
+    }
+    if (Rep_Index < Number_Of_Reps)
+    {
+      printf ("%4d %5d  measured time too small\n", Copy_Index,
+              Copy[Copy_Index].Cpu);
+      ++Errors;
+      continue;
+    }
+    for (Rep_Index = 1; Rep_Index < Number_Of_Reps; ++Rep_Index)
+      Rate [0] += Rate [Rep_Index];
+    printf ("%4d %5d %22.1f %12.1f\n", Copy_Index, Copy[Copy_Index].Cpu,
+            Rate [0] / Number_Of_Reps, Rate [0] / Number_Of_Reps / 1757);
+        /* mean over the repetitions */
+  }
   printf ("\n");
-
-  User_Time = End_Time - Begin_Time;
-
-  if (User_Time < Too_Small_Time)
+  if (Wrong)
+  {
+    printf ("Final values: wrong in %d copies\n", Wrong);
+    printf ("\n");
+  }
+  else if (Errors)
   {
-    printf ("Measured time too small to obtain meaningful results\n");
     printf ("Please increase number of runs\n");
     printf ("\n");
   }
   else
   {
-#ifdef TIME
-    Microseconds = (measure) User_Time * Mic_secs_Per_Second 
-                        / (measure) Number_Of_Runs;
-    Dhrystones_Per_Second = (measure) Number_Of_Runs / (measure) User_Time;
-#else
-    Microseconds = (measure) User_Time * Mic_secs_Per_Second 
-                        / ((measure) HZ * ((measure) Number_Of_Runs));
-    Dhrystones_Per_Second = ((measure) HZ * (measure) Number_Of_Runs)
-                        / (measure) User_Time;
-#endif
-    printf ("Microseconds for one run through Dhrystone: ");
-    printf ("%12.1f \n", Microseconds);
-    printf ("Dhrystones per Second:                      ");
+    Dhrystones_Per_Second = Print_Stats (Sum, Number_Of_Reps);
+        /* of the sums over all copies, the median repetition */
+    printf ("Dhrystones per Second, all copies:         ");
     printf ("%12.1f \n", Dhrystones_Per_Second);
-    printf ("VAX MIPS:                                   ");
-    printf ("%12.1f \n", Dhrystones_Per_Second/1757);
+    printf ("DMIPS, all copies:                         ");
+    printf ("%12.1f \n", Dhrystones_Per_Second / 1757);
+    printf ("DMIPS per copy:                            ");
+    printf ("%12.1f \n", Dhrystones_Per_Second / 1757 / Number_Of_Copies);
     printf ("\n");
   }
-  return 0;
-}
+  munmap ((void *) Go, sizeof (int) + Number_Of_Copies * sizeof (Copy_Type));
+  return Errors ? 1 : 0;
+} /* Run_Copies */
+#endif
 
 
 void Proc_1 (Ptr_Val_Par)
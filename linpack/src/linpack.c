@@ -24,7 +24,50 @@
 ** - Main function return type changed to integer for automation purposes
 ** - Re-organized output for cleaner reports
 **
-** To compile:  cc -O -o linpack linpack.c -lm
+** To compile:  cc -O -o linpack linpack.c -lm -lpthread
+**
+** To run:      linpack [array size [mode]]
+**
+**              linpack [array size parallel|scaling [threads]]
+**
+**              mode selects the factorization:  classic (default, the
+**              average of rolled and unrolled), rolled, unrolled, simd
+**              (vectorized kernels of linpack_simd.h), compare (rolled,
+**              unrolled and simd side by side), blocked (level-3 blocked
+**              LU, see dgefa_b), parallel (dgefa_b on a pool of
+**              threads, see dgefa_p) or, in double precision, mixed
+**              (single precision factorization refined to double
+**              precision accuracy, see dsgesl).  scaling
+**              runs parallel with 1, 2, 4 ... up to threads threads,
+**              by default all online processors, and reports the speedup.
+**
+**              linpack [array size multi [right-hand sides]]
+**
+**              linpack [array size batched [matrices]]
+**
+**              multi solves many right-hand sides, by default as many
+**              as the order of the matrix, one at a time with dgesl and
+**              all at once with dgesl_m.  batched factors and solves many
+**              small matrices of order array size/2, by default enough to
+**              fill BATCH_BYTES, one at a time with the simd kernels and
+**              a vector of them at a time with dgefa_v and dgesl_v.
+**
+**              The solution of every kernel is checked against the
+**              scaled residual limit RESID_LIMIT; linpack exits with 1
+**              if one fails.
+**
+**              linpack [largest array size sweep]
+**
+**              sweep runs rolled, unrolled, simd and blocked for orders
+**              from 50 up, by steps of sqrt(2), to half the array size or
+**              as far as the available memory allows, and prints their
+**              GFLOPS against n next to a roofline model: the memory
+**              bandwidth of a STREAM triad, the GFLOPS of dgemm_b in
+**              cache, and the arithmetic intensity of each kernel.
+**
+**              Times are wall-clock.  With LINPACK_COUNTERS set in the
+**              environment, the hardware counters of the DGEFA and DGESL
+**              phases of each kernel are reported after the table.
 **
 */
 
@@ -33,6 +76,15 @@
 #include <math.h>
 #include <time.h>
 #include <float.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define COUNTERS
+#endif
 
 #ifndef SP
 #ifndef DP
@@ -45,6 +97,7 @@
 #define ONE         1.0
 #define PREC        "Single"
 #define BASE10DIG   FLT_DIG
+#define EPS         FLT_EPSILON
 
 typedef float   REAL;
 #endif
@@ -54,6 +107,7 @@ typedef float   REAL;
 #define ONE         1.0e0
 #define PREC        "Double"
 #define BASE10DIG   DBL_DIG
+#define EPS         DBL_EPSILON
 
 typedef double  REAL;
 #endif
@@ -63,10 +117,237 @@ typedef double  REAL;
  */                                    
 #define MEM_T long
 
-static REAL linpack  (long nreps,int arsize);
+/*
+** Largest scaled residual ||a*x-b||/(||a||*||x||*n*eps) accepted for the
+** solution of a run, as in HPL.
+*/
+#ifndef RESID_LIMIT
+#define RESID_LIMIT 16.0
+#endif
+
+/*
+** Timing loop: the repetitions are doubled until a run takes CALIB_TIME,
+** and the next run is sized from it to take RUN_TIME, the one that counts.
+*/
+#ifndef CALIB_TIME
+#define CALIB_TIME  1.0
+#endif
+#ifndef RUN_TIME
+#define RUN_TIME    10.0
+#endif
+
+/*
+** matgen computes GEN_LANES elements of a column at a time, and splits
+** the matrix between threads when there are at least GEN_COLS columns
+** for each.
+*/
+#define GEN_LANES   8
+#define GEN_COLS    128
+
+/*
+** Hardware counters read around the DGEFA and DGESL phases: cycles, last
+** level cache misses, and on Intel processors the FP_ARITH_INST_RETIRED
+** events of the precision of REAL for scalar, 128, 256 and 512 bit
+** instructions, which count FP operations once weighted by the number of
+** elements of each (an FMA counts twice).  A cache miss is counted as
+** LINE_BYTES of memory traffic.
+*/
+#define CYCLES      0
+#define LLC_MISSES  1
+#define FP_OPS      2
+#define NCOUNTERS   6
+#define LINE_BYTES  64
+
+/*
+** Size sweep: each kernel runs SWEEP_TIME at each order, and is dropped
+** from the larger orders once one repetition takes over SWEEP_MAX/3, as
+** the next order takes about 2.8 times as long.  The sweep stops at the
+** order whose memory, with the snapshot of matset, would take more than
+** half of the available memory.  The triad arrays are STREAM_BYTES each,
+** or 4 times the last level cache if larger.
+*/
+#ifndef SWEEP_TIME
+#define SWEEP_TIME  1.0
+#endif
+#ifndef SWEEP_MAX
+#define SWEEP_MAX   30.0
+#endif
+#ifndef STREAM_BYTES
+#define STREAM_BYTES (64L<<20)
+#endif
+
+/*
+** Most refinement steps of the mixed precision mode, as in LAPACK dsgesv.
+*/
+#ifndef MIXED_ITMAX
+#define MIXED_ITMAX 30
+#endif
+
+/*
+** Blocking of the blocked LU factorization.  NB is the width of the
+** panels, and the depth of the rank-NB update of the trailing matrix.
+** Panels are split recursively down to NBMIN columns, which are factored
+** with level-1 operations.  That update is a matrix product computed
+** by dgemm_b on packed MC x NB tiles of the panel and NB x NC tiles of the
+** block row, mr x NR elements at a time held in registers.  A register
+** tile is NR columns of two vectors of the instruction set picked by
+** simd_init(), up to MRMAX elements; without GNU C on x86 the vectors are
+** those enabled at compile time, VBYTES wide.
+*/
+#ifndef NB
+#define NB          128
+#endif
+#ifndef NBMIN
+#define NBMIN       16
+#endif
+#ifndef MC
+#define MC          192
+#endif
+#ifndef NC
+#define NC          2048
+#endif
+#if defined(__AVX512F__)
+#define VBYTES      64
+#elif defined(__AVX__)
+#define VBYTES      32
+#else
+#define VBYTES      16
+#endif
+#define MR          (2*VBYTES/(int)sizeof(REAL))
+#define MRMAX       (2*64/(int)sizeof(REAL))
+#define NR          6
+#define PACKSIZE    (MC*NB+MRMAX*NB+NB*NC+NB*NR)
+
+/*
+** Batched mode: the matrices are interleaved by groups of vlanes, one per
+** element of a vector of the instruction set picked by simd_init(), so
+** that the factorization of a group proceeds in vector operations across
+** its matrices.  By default the batch fills BATCH_BYTES.
+*/
+#ifndef BATCH_BYTES
+#define BATCH_BYTES (32L<<20)
+#endif
+
+/*
+** Factorization kernels, and the benchmark modes timing them.  The
+** performance of a mode is the average over its kernels, or with columns
+** set the KFLOPS of each of them side by side.  The kernels from SIMD on
+** use the vectorized level-1 routines.
+*/
+#define ROLLED      0
+#define UNROLLED    1
+#define SIMD        2
+#define BLOCKED     3
+#define PARALLEL    4
+#define MIXED       5
+#define MULTI       6
+#define BATCHED     7
+
+static char *kernel_names[] = { "Rolled","Unrolled","SIMD","Blocked","Parallel","Mixed",
+                                "Multi","Batched" };
+
+static struct
+    {
+    char *name;
+    char *title;
+    int   columns;
+    int   nkernels;
+    int   kernels[3];
+    } modes[] =
+    {
+    { "classic",  "Average rolled and unrolled performance", 0, 2, { ROLLED,UNROLLED } },
+    { "rolled",   "Rolled performance",                      0, 1, { ROLLED } },
+    { "unrolled", "Unrolled performance",                    0, 1, { UNROLLED } },
+    { "simd",     "SIMD performance",                        0, 1, { SIMD } },
+    { "compare",  "Rolled, unrolled and SIMD KFLOPS",        1, 3, { ROLLED,UNROLLED,SIMD } },
+    { "blocked",  "Blocked LU performance",                  0, 1, { BLOCKED } },
+    { "parallel", "Parallel blocked LU performance",         0, 1, { PARALLEL } },
+    { "scaling",  "Parallel blocked LU scaling",             0, 1, { PARALLEL } },
+#ifdef DP
+    { "mixed",    "Mixed precision LU performance",          0, 1, { MIXED } },
+#endif
+    { "multi",    "Blocked LU, one and all right-hand sides at a time, KFLOPS",
+                                                             1, 2, { BLOCKED,MULTI } },
+#ifdef __GNUC__
+    { "batched",  "Small LU, one and a vector of matrices at a time, KFLOPS",
+                                                             1, 2, { SIMD,BATCHED } },
+#endif
+    { "sweep",    "Problem size sweep, GFLOPS",              1, 0, { 0 } },
+    };
+#define NMODES      (int)(sizeof(modes)/sizeof(modes[0]))
+
+/*
+** Pool of threads sharing the trailing updates of dgefa_p.  The master
+** thread publishes a step (the panel k0 to k1-1 just factored) and all
+** threads take chunks of NB columns from next on, each with its own
+** packing buffers.
+*/
+static struct
+    {
+    int               nthreads,quit;
+    pthread_t        *thread;
+    pthread_barrier_t start,done;
+    pthread_mutex_t   lock;
+    REAL            **work;
+    REAL             *a;
+    int               lda,n,k0,k1,next,*ipvt;
+    } pool;
+
+/*
+** Threads of matgen: thread id generates columns and then sums rows of
+** its share, the largest element of its columns going to norma[id].
+*/
+static struct
+    {
+    int               nthreads;
+    pthread_barrier_t half;
+    REAL             *a,*b,*norma;
+    int               lda,n;
+    } gen;
+
+static double linpack(long nreps,int arsize,int mode,REAL *rate);
+static double linpack_v(long nreps,int n,int count,int mode);
+static void timebox  (int arsize,int mode,int count,REAL *rate);
+static int  sweep    (int arsize);
+static double stream (void);
+static double peak   (void);
+static int  scaling  (int arsize,int mode,int maxthreads);
+static REAL residual (REAL *a,int lda,int n,REAL *b,REAL *x);
+static REAL residual_m(REAL *a,int lda,int n,REAL *b,int nrhs,REAL *x);
+static int  check    (int mode);
 static void matgen   (REAL *a,int lda,int n,REAL *b,REAL *norma);
-static void dgefa    (REAL *a,int lda,int n,int *ipvt,int *info,int roll);
-static void dgesl    (REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll);
+static void *matgen_part(void *arg);
+static int  lcg_jump (int init,long k);
+static void matset   (REAL *a,int lda,int n,REAL *b);
+static void matgen_v (REAL *a,int n,int count,int lanes,REAL *b);
+static REAL residual_v(REAL *a,int n,int count,int lanes,REAL *b,REAL *x);
+static void dgefa    (REAL *a,int lda,int n,int *ipvt,int *info,int kernel);
+static void dgefa_b  (REAL *a,int lda,int n,int *ipvt,int *info);
+static void dgefa_p  (REAL *a,int lda,int n,int *ipvt,int *info);
+static void dpanel_b (REAL *a,int lda,int n,int k0,int k1,int *ipvt,int *info,
+                      REAL *work);
+static void dupdate_b(REAL *a,int lda,int n,int k0,int k1,int j0,int j1,
+                      int *ipvt,REAL *work);
+static void dlaswp_b (REAL *a,int lda,int j0,int j1,int k0,int k1,int *ipvt);
+static void dorder_b (REAL *a,int lda,int k0,int k1,int *ipvt);
+static void dgemm_b  (int m,int n,int k,REAL *a,int lda,REAL *b,int ldb,
+                      REAL *c,int ldc,REAL *work);
+#ifndef __GNUC__
+static void dgemm_kernel(int k,REAL *pa,REAL *pb,REAL *c,int ldc,int m,int n);
+#endif
+static void dgesl    (REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int kernel);
+static void dgesl_m  (REAL *a,int lda,int n,int *ipvt,REAL *b,int ldb,int nrhs);
+static void dreorder_b(REAL *a,int lda,int k0,int k1,int *ipvt);
+#ifdef DP
+static void dsgefa   (REAL *a,int lda,int n,float *sa,int *ipvt,int *info);
+static int  dsgesl   (REAL *a,int lda,int n,float *sa,int *ipvt,REAL *b,
+                      float *sb,REAL *work);
+static void sgefa    (float *a,int lda,int n,int *ipvt,int *info);
+static void sgesl    (float *a,int lda,int n,int *ipvt,float *b);
+static void saxpy_r  (int n,float da,float *dx,int incx,float *dy,int incy);
+static void sscal_r  (int n,float da,float *dx,int incx);
+static int  isamax   (int n,float *dx,int incx);
+#endif
 static void daxpy_r  (int n,REAL da,REAL *dx,int incx,REAL *dy,int incy);
 static REAL ddot_r   (int n,REAL *dx,int incx,REAL *dy,int incy);
 static void dscal_r  (int n,REAL da,REAL *dx,int incx);
@@ -74,20 +355,135 @@ static void daxpy_ur (int n,REAL da,REAL *dx,int incx,REAL *dy,int incy);
 static REAL ddot_ur  (int n,REAL *dx,int incx,REAL *dy,int incy);
 static void dscal_ur (int n,REAL da,REAL *dx,int incx);
 static int  idamax   (int n,REAL *dx,int incx);
-static REAL second   (void);
+static char *simd_init(void);
+static void pool_start(int nthreads);
+static void pool_stop(void);
+static void *pool_worker(void *arg);
+static void pool_update(int id);
+static char *counters_init(void);
+static void counters_read(long long *count);
+static void counters_report(int mode);
+static double second (void);
 
 static void *mempool;
+static REAL *snapshot;
+static int   snapshot_n;
+static REAL  packbuf[PACKSIZE];
+static REAL  resid[3];
+static int   quiet;
+static int   refine_steps;
+static int   nrhs = 1;
+
+/*
+** Vectorized level-1 kernels, pointed by simd_init() at the versions of
+** linpack_simd.h for the widest instruction set the processor supports.
+** Without GNU C on x86 they are the unrolled kernels.
+*/
+static void (*daxpy_s)(int n,REAL da,REAL *dx,int incx,REAL *dy,int incy);
+static REAL (*ddot_s) (int n,REAL *dx,int incx,REAL *dy,int incy);
+static void (*dscal_s)(int n,REAL da,REAL *dx,int incx);
+static int  (*idamax_s)(int n,REAL *dx,int incx);
+#ifdef DP
+static void (*saxpy_s)(int n,float da,float *dx,int incx,float *dy,int incy);
+static void (*sscal_s)(int n,float da,float *dx,int incx);
+static int  (*isamax_s)(int n,float *dx,int incx);
+#endif
+static char *simd_isa;
+
+/*
+** Register tile of dgemm_b and batched kernels of linpack_gemm.h, also
+** pointed by simd_init() at the widest instruction set, with the rows mr
+** of the tile and the matrices vlanes factored side by side that go with
+** them.
+*/
+static void (*dgemm_kernel_s)(int k,REAL *pa,REAL *pb,REAL *c,int ldc,int m,int n);
+#ifdef __GNUC__
+static void (*dgefa_v_s)(REAL *a,int n,int *ipvt,int *info);
+static void (*dgesl_v_s)(REAL *a,int n,int *ipvt,REAL *b);
+#endif
+static int   mr = MR;
+static int   vlanes = VBYTES/(int)sizeof(REAL);
+
+/*
+** Whether counters were asked for, the counters open, and the time, flops
+** and counts of the DGEFA (0) and DGESL (1) phases of each kernel in the
+** last call to linpack().
+*/
+static int   counter_fd[NCOUNTERS];
+static int   counters;
+static struct
+    {
+    double    time,flops;
+    long long count[NCOUNTERS];
+    } phase[3][2];
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#include <immintrin.h>
+#define SIMD_LEVEL 1
+#include "linpack_simd.h"
+#include "linpack_gemm.h"
+#undef SIMD_LEVEL
+#define SIMD_LEVEL 2
+#include "linpack_simd.h"
+#include "linpack_gemm.h"
+#undef SIMD_LEVEL
+#define SIMD_LEVEL 3
+#include "linpack_simd.h"
+#include "linpack_gemm.h"
+#undef SIMD_LEVEL
+#ifdef DP
+#define SIMD_SINGLE
+#define SIMD_LEVEL 1
+#include "linpack_simd.h"
+#undef SIMD_LEVEL
+#define SIMD_LEVEL 2
+#include "linpack_simd.h"
+#undef SIMD_LEVEL
+#define SIMD_LEVEL 3
+#include "linpack_simd.h"
+#undef SIMD_LEVEL
+#undef SIMD_SINGLE
+#endif
+#elif defined(__GNUC__)
+#define SIMD_LEVEL 0
+#include "linpack_gemm.h"
+#undef SIMD_LEVEL
+#endif
 
 
 int main(int argc, char **argv)
 
     {
-    char    buf[80];
-    int     arsize;
-    long    arsize2d,nreps;
+    char    buf[80],*cname;
+    int     arsize,mode,nthreads,count,i,failed;
+    long    arsize2d;
+    REAL    kflops;
     size_t  malloc_arg;
     MEM_T   memreq;
 
+    simd_isa = simd_init();
+    cname = counters_init();
+    gen.nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    failed = 0;
+    mode = 0;
+    if (argc > 2)
+        {
+        for (mode = 0; mode < NMODES; mode++)
+            if (strcmp(argv[2],modes[mode].name) == 0)
+                break;
+        if (mode == NMODES)
+            {
+            printf("Unknown mode %s, expected one of:",argv[2]);
+            for (mode = 0; mode < NMODES; mode++)
+                printf(" %s",modes[mode].name);
+            printf("\n");
+            return 1;
+            }
+        }
+    nthreads = (argc > 3) ? atoi(argv[3]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1)
+        nthreads = 1;
     while (1)
         {
 	if (argc < 2)
@@ -111,8 +507,29 @@ int main(int argc, char **argv)
 	    if (argc > 1) break;
             continue;
             }
+        if (strcmp(modes[mode].name,"sweep") == 0)
+            {
+            failed |= sweep(arsize);
+            printf("\n");
+	    if (argc > 1) break;
+            continue;
+            }
         arsize2d = (long)arsize*(long)arsize;
-        memreq=arsize2d*sizeof(REAL)+(long)arsize*sizeof(REAL)+(long)arsize*sizeof(int);
+        count = (argc > 3) ? atoi(argv[3]) : 0;
+        if (modes[mode].kernels[1] == MULTI)
+            nrhs = (count > 0) ? count : arsize/2;
+        if (modes[mode].kernels[1] == BATCHED)
+            {
+            if (count < 1)
+                count = (int)(BATCH_BYTES/((long)arsize*arsize/4*sizeof(REAL)));
+            count = (count + vlanes-1)/vlanes*vlanes;
+            }
+        memreq=arsize2d*sizeof(REAL)+(nrhs+1L)*arsize*sizeof(REAL)+(long)arsize*sizeof(int);
+        if (modes[mode].kernels[0] == MIXED)
+            memreq+=arsize2d*sizeof(float)+(long)arsize*sizeof(float);
+        if (modes[mode].kernels[1] == BATCHED)
+            memreq=(long)count*(arsize/2)*(arsize/2+2L)*sizeof(REAL)+
+                   (long)count*(arsize/2)*sizeof(int);
         malloc_arg=(size_t)memreq;
         if ((MEM_T)malloc_arg!=memreq || (mempool=malloc(malloc_arg))==NULL)
             {
@@ -120,105 +537,895 @@ int main(int argc, char **argv)
 	    if (argc > 1) break;
             continue;
             }
+        snapshot=(REAL *)malloc((arsize2d/2+arsize/2)*sizeof(REAL));
+        snapshot_n=0;
         printf("LINPACK benchmark, %s precision.\n",PREC);
         printf("Machine precision:  %d digits.\n",BASE10DIG);
         printf("Array size %d X %d.\n",arsize,arsize);
         printf("Memory required:  %ldK.\n",(memreq+512L)>>10);
-        printf("Average rolled and unrolled performance:\n\n");
-        printf("    Reps Time(s) DGEFA   DGESL  OVERHEAD    KFLOPS\n");
-        printf("----------------------------------------------------\n");
-        nreps=1;
-        while (linpack(nreps,arsize)<10.)
-            nreps*=2;
+        for (i=0;i<modes[mode].nkernels;i++)
+            if (modes[mode].kernels[i] >= SIMD)
+                break;
+        if (i < modes[mode].nkernels)
+            printf("SIMD kernels:  %s.\n",simd_isa);
+        if (cname != NULL)
+            printf("Hardware counters:  %s.\n",cname);
+        if (strcmp(modes[mode].name,"scaling") == 0)
+            failed |= scaling(arsize,mode,nthreads);
+        else
+            {
+            if (modes[mode].kernels[0] == PARALLEL)
+                {
+                printf("%s, %d thread(s), NB=%d, %dx%d register tiles:\n\n",
+                       modes[mode].title,nthreads,NB,mr,NR);
+                pool_start(nthreads);
+                }
+            else if (modes[mode].kernels[1] == MULTI)
+                printf("%s, %d right-hand sides, NB=%d:\n\n",
+                       modes[mode].title,nrhs,NB);
+            else if (modes[mode].kernels[0] == BLOCKED)
+                printf("%s, NB=%d, %dx%d register tiles:\n\n",
+                       modes[mode].title,NB,mr,NR);
+            else if (modes[mode].kernels[0] == MIXED)
+                printf("%s, single precision DGEFA, double precision "
+                       "accurate DGESL:\n\n",modes[mode].title);
+            else if (modes[mode].kernels[1] == BATCHED)
+                printf("%s, %d matrices of order %d, %d per vector:\n\n",
+                       modes[mode].title,count,arsize/2,vlanes);
+            else
+                printf("%s:\n\n",modes[mode].title);
+            if (modes[mode].columns)
+                {
+                printf("    Reps Time(s)");
+                for (i=0;i<modes[mode].nkernels;i++)
+                    printf(" %12s",kernel_names[modes[mode].kernels[i]]);
+                printf("\n---------------");
+                for (i=0;i<modes[mode].nkernels;i++)
+                    printf("-------------");
+                printf("\n");
+                }
+            else
+                {
+                printf("    Reps Time(s) DGEFA   DGESL  OVERHEAD    KFLOPS\n");
+                printf("----------------------------------------------------\n");
+                }
+            timebox(arsize,mode,count,&kflops);
+            if (modes[mode].kernels[0] == PARALLEL)
+                pool_stop();
+            if (modes[mode].kernels[0] == MIXED)
+                printf("Effective rate %.3f GFLOPS, %d refinement step(s) "
+                       "per solve.\n",kflops/1.0e6,refine_steps);
+            if (counters && modes[mode].kernels[1] != BATCHED)
+                counters_report(mode);
+            failed |= check(mode);
+            }
+        free(snapshot);
         free(mempool);
         printf("\n");
 	if (argc > 1) break;
         }
-	return 0;
+	return failed;
+    }
+
+
+/*
+** Runs parallel mode with 1, 2, 4 ... threads up to maxthreads and
+** summarizes the KFLOPS of the last line of each run against 1 thread.
+** Returns nonzero if a residual check failed.
+*/
+static int scaling(int arsize,int mode,int maxthreads)
+
+    {
+    REAL   kflops[32];
+    int    i,nruns,nthreads,failed;
+
+    printf("%s, NB=%d, %dx%d register tiles:\n",
+           modes[mode].title,NB,mr,NR);
+    nruns=0;
+    failed=0;
+    for (nthreads=1;;nthreads*=2)
+        {
+        if (nthreads > maxthreads)
+            nthreads = maxthreads;
+        printf("\n%d thread(s):\n",nthreads);
+        printf("    Reps Time(s) DGEFA   DGESL  OVERHEAD    KFLOPS\n");
+        printf("----------------------------------------------------\n");
+        pool_start(nthreads);
+        timebox(arsize,mode,0,&kflops[nruns]);
+        pool_stop();
+        if (counters)
+            counters_report(mode);
+        failed |= check(mode);
+        nruns++;
+        if (nthreads == maxthreads)
+            break;
+        }
+    printf("\n Threads       KFLOPS  Speedup  Efficiency\n");
+    printf("-------------------------------------------\n");
+    for (i=0,nthreads=1;i<nruns;i++,nthreads*=2)
+        {
+        if (nthreads > maxthreads)
+            nthreads = maxthreads;
+        printf("%8d %12.3f %8.2f %10.1f%%\n",nthreads,kflops[i],
+               kflops[i]/kflops[0],100.*kflops[i]/(kflops[0]*nthreads));
+        }
+    return(failed);
+    }
+
+
+/*
+** Runs linpack(), or linpack_v() for count matrices in batched mode, with
+** 1, 2, 4 ... repetitions until a run takes CALIB_TIME, then once with as
+** many as should take RUN_TIME.  Only that last run is long, so most of
+** the time goes to the run that is reported last, where the doubling up to
+** RUN_TIME threw away as much time as it kept.  rate gets its KFLOPS.
+*/
+static void timebox(int arsize,int mode,int count,REAL *rate)
+
+    {
+    double t;
+    long  nreps;
+
+    for (nreps=1;;nreps*=2)
+        {
+        if (modes[mode].kernels[1] == BATCHED)
+            t=linpack_v(nreps,arsize/2,count,mode);
+        else
+            t=linpack(nreps,arsize,mode,rate);
+        if (t>=CALIB_TIME)
+            break;
+        }
+    if (t>=RUN_TIME)
+        return;
+    nreps=(long)(nreps*RUN_TIME/t)+1;
+    if (modes[mode].kernels[1] == BATCHED)
+        linpack_v(nreps,arsize/2,count,mode);
+    else
+        linpack(nreps,arsize,mode,rate);
+    }
+
+
+static double linpack(long nreps,int arsize,int mode,REAL *rate)
+
+    {
+    REAL  *a,*b,*x;
+#ifdef DP
+    float *sa,*sb;
+#endif
+    REAL   kflops,ops;
+    double t1,tdgesl,tdgefa,totalt,toverhead;
+    double tkernel[3];
+    long long c0[NCOUNTERS],c1[NCOUNTERS];
+    int   *ipvt,n,info,lda,k,kernel,j,e;
+    long   i,arsize2d;
+
+    lda = arsize;
+    n = arsize/2;
+    arsize2d = (long)arsize*(long)arsize;
+    ops=((2.0*n*n*n)/3.0+2.0*n*n*nrhs);
+    a=(REAL *)mempool;
+    b=a+arsize2d;
+    x=b+(long)arsize*nrhs;
+    ipvt=(int *)&x[arsize];
+#ifdef DP
+    sa=(float *)&ipvt[arsize];
+    sb=sa+arsize2d;
+#endif
+    tdgesl=0;
+    tdgefa=0;
+    totalt=second();
+    for (k=0;k<modes[mode].nkernels;k++)
+        {
+        kernel=modes[mode].kernels[k];
+        tkernel[k]=tdgefa+tdgesl;
+        memset(phase[k],0,sizeof(phase[k]));
+        phase[k][0].flops=nreps*(2.0*n*n*n)/3.0;
+        phase[k][1].flops=nreps*2.0*n*n*nrhs;
+        for (i=0;i<nreps;i++)
+            {
+            matset(a,lda,n,b);
+            for (j=1;j<nrhs;j++)
+                memcpy(&b[(long)lda*j],b,n*sizeof(REAL));
+            if (counters)
+                counters_read(c0);
+            t1 = second();
+            if (kernel == PARALLEL)
+                dgefa_p(a,lda,n,ipvt,&info);
+            else if (kernel == BLOCKED || kernel == MULTI)
+                dgefa_b(a,lda,n,ipvt,&info);
+#ifdef DP
+            else if (kernel == MIXED)
+                dsgefa(a,lda,n,sa,ipvt,&info);
+#endif
+            else
+                dgefa(a,lda,n,ipvt,&info,kernel);
+            t1 = second()-t1;
+            tdgefa += t1;
+            phase[k][0].time += t1;
+            if (counters)
+                {
+                counters_read(c1);
+                for (e=0;e<NCOUNTERS;e++)
+                    phase[k][0].count[e] += c1[e]-c0[e];
+                counters_read(c0);
+                }
+            t1 = second();
+#ifdef DP
+            if (kernel == MIXED)
+                refine_steps=dsgesl(a,lda,n,sa,ipvt,b,sb,x);
+            else
+#endif
+            if (kernel == MULTI)
+                dgesl_m(a,lda,n,ipvt,b,lda,nrhs);
+            else
+                for (j=0;j<nrhs;j++)
+                    dgesl(a,lda,n,ipvt,&b[(long)lda*j],0,(kernel > SIMD) ? SIMD : kernel);
+            t1 = second()-t1;
+            tdgesl += t1;
+            phase[k][1].time += t1;
+            if (counters)
+                {
+                counters_read(c1);
+                for (e=0;e<NCOUNTERS;e++)
+                    phase[k][1].count[e] += c1[e]-c0[e];
+                }
+            }
+        tkernel[k]=tdgefa+tdgesl-tkernel[k];
+        if (nrhs > 1)
+            resid[k]=residual_m(a,lda,n,b,nrhs,x);
+        else
+            {
+            for (i=0;i<n;i++)
+                x[i]=b[i];
+            resid[k]=residual(a,lda,n,b,x);
+            }
+        }
+    totalt=second()-totalt;
+    if (totalt<0.5 || tdgefa+tdgesl<0.2)
+        return(0.);
+    kflops=modes[mode].nkernels*nreps*ops/(1000.*(tdgefa+tdgesl));
+    toverhead=totalt-tdgefa-tdgesl;
+    if (tdgefa<0.)
+        tdgefa=0.;
+    if (tdgesl<0.)
+        tdgesl=0.;
+    if (toverhead<0.)
+        toverhead=0.;
+    if (!quiet)
+        {
+        if (modes[mode].columns)
+            {
+            printf("%8ld %6.2f",nreps,totalt);
+            for (k=0;k<modes[mode].nkernels;k++)
+                printf(" %12.3f",(tkernel[k] > 0.) ? nreps*ops/(1000.*tkernel[k]) : 0.);
+            printf("\n");
+            }
+        else
+            printf("%8ld %6.2f %6.2f%% %6.2f%% %6.2f%%  %9.3f\n",
+                    nreps,totalt,100.*tdgefa/totalt,
+                    100.*tdgesl/totalt,100.*toverhead/totalt,
+                    kflops);
+        }
+    if (rate != NULL)
+        *rate=kflops;
+    return(totalt);
+    }
+
+
+/*
+** Size sweep.  Every order n from 50 on, by steps of sqrt(2) up to
+** arsize/2 or the memory limit, is run by each of the rolled, unrolled,
+** simd and blocked modes, with doubling repetitions up to SWEEP_TIME, and
+** one line gives their GFLOPS.  The lines start with n and have # in
+** front of everything else, so that they can be plotted as they are.
+**
+** The roofline is drawn from a STREAM triad (bandwidth, in GB/s) and
+** dgemm_b in cache on the register tile picked by simd_init() (peak, in
+** GFLOPS).  The arithmetic intensity of a kernel is the flops per byte of
+** the traffic it cannot avoid: dgefa streams the trailing matrix in and
+** out at each step, two elements for every 2 flops of its daxpys, which
+** gives 1/sizeof(REAL) for the level-1 kernels; dgefa_b does it once every
+** NB columns, NB/sizeof(REAL).  Both are capped by n/(3 sizeof(REAL)), for
+** 2n^3/3 flops reading and writing the matrix once.  A kernel can beat the
+** memory roof while the matrix fits in cache.  Returns nonzero if a
+** residual check failed.
+*/
+static int sweep(int arsize)
+
+    {
+    static char *names[4] = { "rolled","unrolled","simd","blocked" };
+    REAL   rate;
+    double bw,gf,t,x,ai[2],roof[2],avail,gflops[4],lev1,blk,cap;
+    long   nreps;
+    int    mode[4],drop[4],k,n,nmax,failed;
+    size_t bytes;
+
+    for (k = 0; k < 4; k++)
+        {
+        for (mode[k] = 0; strcmp(modes[mode[k]].name,names[k]) != 0; mode[k]++)
+            ;
+        drop[k] = 0;
+        }
+    avail = (double)sysconf(_SC_AVPHYS_PAGES)*(double)sysconf(_SC_PAGESIZE);
+    nmax = (int)sqrt(avail/2./(6.*sizeof(REAL)));
+    if (nmax > arsize/2)
+        nmax = arsize/2;
+    printf("LINPACK size sweep, %s precision.\n",PREC);
+    printf("SIMD kernels:  %s.\n",simd_isa);
+    bytes = (size_t)(4L*nmax*nmax+6L*nmax)*sizeof(REAL)+(size_t)2*nmax*sizeof(int);
+    while ((mempool = malloc(bytes)) == NULL && nmax > 50)
+        {
+        nmax = nmax*7/10;
+        bytes = (size_t)(4L*nmax*nmax+6L*nmax)*sizeof(REAL)+(size_t)2*nmax*sizeof(int);
+        }
+    if (mempool == NULL)
+        {
+        printf("Not enough memory available for the sweep.\n");
+        return(1);
+        }
+    snapshot = (REAL *)malloc((size_t)(2L*nmax*nmax+nmax)*sizeof(REAL));
+    snapshot_n = 0;
+    bw = stream();
+    gf = peak();
+    printf("# Memory bandwidth (triad):      %10.3f GB/s\n",bw);
+    lev1 = 2./(2.*sizeof(REAL));
+    blk = 2.*NB/(2.*sizeof(REAL));
+    printf("# Peak (dgemm_b in cache):       %10.3f GFLOPS, %s\n",gf,simd_isa);
+    printf("# Ridge point:                   %10.3f flops/byte\n",gf/bw);
+    printf("# Intensity (flops/byte):        %10.3f level 1, %.3f blocked (NB=%d)\n",
+           lev1,blk,NB);
+    printf("# Largest order:                 %10d\n",nmax);
+    printf("#\n#     n     MB   AI(lev1)  AI(blk)     Rolled   Unrolled       SIMD"
+           "    Blocked  Roof(lev1)  Roof(blk)\n");
+    failed = 0;
+    quiet = 1;
+    for (x = 50.; (n = (int)(x+0.5)) <= nmax; x *= M_SQRT2)
+        {
+        for (k = 0; k < 4; k++)
+            {
+            gflops[k] = -1.;
+            if (drop[k])
+                continue;
+            for (nreps = 1;; nreps *= 2)
+                if ((t = linpack(nreps,2*n,mode[k],&rate)) >= SWEEP_TIME)
+                    break;
+            gflops[k] = rate/1.0e6;
+            if (t/nreps > SWEEP_MAX/3.)
+                drop[k] = 1;
+            if (resid[0] < 0. || resid[0] > RESID_LIMIT)
+                {
+                printf("# Scaled residual of %s at n=%d: %.3f, FAILED, limit %g\n",
+                       names[k],n,resid[0],RESID_LIMIT);
+                failed = 1;
+                }
+            }
+        cap = n/(3.*sizeof(REAL));
+        ai[0] = (cap < lev1) ? cap : lev1;
+        ai[1] = (cap < blk) ? cap : blk;
+        for (k = 0; k < 2; k++)
+            roof[k] = (ai[k]*bw < gf) ? ai[k]*bw : gf;
+        printf("%7d %6.1f %10.3f %8.3f",n,(double)n*n*sizeof(REAL)/1.0e6,ai[0],ai[1]);
+        for (k = 0; k < 4; k++)
+            if (gflops[k] >= 0.)
+                printf(" %10.3f",gflops[k]);
+            else
+                printf(" %10s","-");
+        printf(" %11.3f %10.3f\n",roof[0],roof[1]);
+        fflush(stdout);
+        }
+    quiet = 0;
+    free(snapshot);
+    free(mempool);
+    snapshot = NULL;
+    return(failed);
+    }
+
+
+/*
+** STREAM triad a = b + s*c, in GB/s, counting 3 elements of traffic per
+** iteration and keeping the best of 5 passes, on arrays of STREAM_BYTES
+** or 4 times the last level cache.  Smaller arrays are tried when memory
+** is short.
+*/
+static double stream(void)
+
+    {
+    REAL  *a,*b,*c;
+    double t,best;
+    long   i,n,llc;
+    int    pass;
+
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    n = ((4*llc > STREAM_BYTES) ? 4*llc : STREAM_BYTES)/(long)sizeof(REAL);
+    while ((a = (REAL *)malloc(3*n*sizeof(REAL))) == NULL && n > 1024)
+        n /= 2;
+    if (a == NULL)
+        return(0.);
+    b = a+n;
+    c = b+n;
+    for (i = 0; i < n; i++)
+        {
+        a[i] = ZERO;
+        b[i] = ONE;
+        c[i] = 2.0;
+        }
+    best = 0.;
+    for (pass = 0; pass < 5; pass++)
+        {
+        t = second();
+        for (i = 0; i < n; i++)
+            a[i] = b[i]+3.0*c[i];
+        t = second()-t;
+        if (t > 0. && 3.*n*sizeof(REAL)/t/1.0e9 > best)
+            best = 3.*n*sizeof(REAL)/t/1.0e9;
+        }
+    if (a[n/2] != 7.0)
+        printf("# Triad check failed.\n");
+    free(a);
+    return(best);
+    }
+
+
+/*
+** GFLOPS of dgemm_b on 4MC x NB by NB x 4MC blocks, the shape of the
+** trailing update of dgefa_b, small enough to stay in cache: the compute
+** roof of the blocked kernel.
+*/
+static double peak(void)
+
+    {
+    REAL  *a,*b,*c;
+    double t,flops;
+    long   i,reps;
+
+    a = (REAL *)malloc(sizeof(REAL)*(8L*MC*NB+16L*MC*MC));
+    if (a == NULL)
+        return(0.);
+    b = a+4*MC*NB;
+    c = b+4*MC*NB;
+    for (i = 0; i < 8L*MC*NB+16L*MC*MC; i++)
+        a[i] = (i%7)*0.125;
+    flops = 0.;
+    t = second();
+    for (reps = 1; second()-t < 0.5; reps++)
+        {
+        dgemm_b(4*MC,4*MC,NB,a,4*MC,b,NB,c,4*MC,packbuf);
+        flops += 2.0*4*MC*NB*4*MC;
+        }
+    t = second()-t;
+    free(a);
+    return(flops/t/1.0e9);
+    }
+
+
+/*
+** Batched counterpart of linpack(): each repetition factors and solves
+** count independent matrices of order n, by each kernel of the mode, and
+** the KFLOPS of each kernel are printed in columns.  The SIMD kernel runs
+** dgefa and dgesl on one matrix after the other; the BATCHED kernel runs
+** dgefa_v and dgesl_v on groups of vlanes interleaved matrices.
+*/
+static double linpack_v(long nreps,int n,int count,int mode)
+
+    {
+    REAL  *a,*b,*x;
+    REAL   ops;
+    double t1,totalt;
+    double tkernel[3];
+    int   *ipvt,info,k,kernel,lanes,m;
+    long   i,nn;
+
+    nn = (long)n*n;
+    ops=count*((2.0*n*n*n)/3.0+2.0*n*n);
+    a=(REAL *)mempool;
+    b=a+count*nn;
+    x=b+(long)count*n;
+    ipvt=(int *)&x[(long)count*n];
+    totalt=second();
+    for (k=0;k<modes[mode].nkernels;k++)
+        {
+        kernel=modes[mode].kernels[k];
+        lanes=(kernel == BATCHED) ? vlanes : 1;
+        tkernel[k]=0.;
+        for (i=0;i<nreps;i++)
+            {
+            matgen_v(a,n,count,lanes,b);
+            t1 = second();
+            for (m=0;m<count;m+=lanes)
+                {
+                if (kernel == BATCHED)
+                    {
+                    dgefa_v_s(&a[m*nn],n,&ipvt[(long)m*n],&info);
+                    dgesl_v_s(&a[m*nn],n,&ipvt[(long)m*n],&b[(long)m*n]);
+                    }
+                else
+                    {
+                    dgefa(&a[m*nn],n,n,&ipvt[(long)m*n],&info,kernel);
+                    dgesl(&a[m*nn],n,n,&ipvt[(long)m*n],&b[(long)m*n],0,kernel);
+                    }
+                }
+            tkernel[k] += second()-t1;
+            }
+        for (i=0;i<(long)count*n;i++)
+            x[i]=b[i];
+        resid[k]=residual_v(a,n,count,lanes,b,x);
+        }
+    totalt=second()-totalt;
+    if (totalt<0.5 || tkernel[0]<0.1)
+        return(0.);
+    printf("%8ld %6.2f",nreps,totalt);
+    for (k=0;k<modes[mode].nkernels;k++)
+        printf(" %12.3f",(tkernel[k] > 0.) ? nreps*ops/(1000.*tkernel[k]) : 0.);
+    printf("\n");
+    return(totalt);
+    }
+
+
+/*
+** Scaled residual of the solution x of the last run, in the infinity norm:
+**
+**      ||a*x-b|| / (||a|| * ||x|| * n * eps)
+**
+** a and b are set again by matset, since dgefa and dgesl overwrite
+** them, and b is left holding a*x-b.  A correct solution gives a value of
+** order 1; RESID_LIMIT is the largest accepted.
+*/
+static REAL residual(REAL *a,int lda,int n,REAL *b,REAL *x)
+
+    {
+    REAL   norma,normx,normr,t;
+    double *rowsum;
+    int    i,j;
+
+    rowsum = (double *)malloc(sizeof(double)*n);
+    if (rowsum == NULL)
+        {
+        printf("Not enough memory available for the residual check.\n");
+        exit(1);
+        }
+    matset(a,lda,n,b);
+    for (i = 0; i < n; i++)
+        {
+        b[i] = -b[i];
+        rowsum[i] = 0.0;
+        }
+    for (j = 0; j < n; j++)
+        for (i = 0; i < n; i++)
+            {
+            b[i] = b[i] + a[lda*j+i]*x[j];
+            rowsum[i] = rowsum[i] + fabs((double)a[lda*j+i]);
+            }
+    norma = normx = normr = ZERO;
+    for (i = 0; i < n; i++)
+        {
+        if (rowsum[i] > norma)
+            norma = (REAL)rowsum[i];
+        t = (REAL)fabs((double)x[i]);
+        if (t > normx)
+            normx = t;
+        t = (REAL)fabs((double)b[i]);
+        if (t > normr)
+            normr = t;
+        }
+    free(rowsum);
+    return (normr/(norma*normx*n*EPS));
+    }
+
+
+/*
+** Largest scaled residual of the nrhs solutions in the columns of b, all
+** of the system of matset, so that a wrong column of dgesl_m cannot hide
+** behind a right one.  Leaves a and the first column of b regenerated, and
+** x holding the first solution.
+*/
+static REAL residual_m(REAL *a,int lda,int n,REAL *b,int nrhs,REAL *x)
+
+    {
+    REAL  *r,*xm;
+    REAL   norma,normx,normr,t,worst;
+    double *rowsum;
+    int    i,j,m;
+
+    rowsum = (double *)malloc(sizeof(double)*n);
+    r = (REAL *)malloc(sizeof(REAL)*n);
+    if (rowsum == NULL || r == NULL)
+        {
+        printf("Not enough memory available for the residual check.\n");
+        exit(1);
+        }
+    for (i = 0; i < n; i++)
+        x[i] = b[i];
+    matset(a,lda,n,b);
+    norma = ZERO;
+    for (i = 0; i < n; i++)
+        rowsum[i] = 0.0;
+    for (j = 0; j < n; j++)
+        for (i = 0; i < n; i++)
+            rowsum[i] = rowsum[i] + fabs((double)a[lda*j+i]);
+    for (i = 0; i < n; i++)
+        if (rowsum[i] > norma)
+            norma = (REAL)rowsum[i];
+    worst = ZERO;
+    for (m = 0; m < nrhs; m++)
+        {
+        xm = (m == 0) ? x : &b[(long)lda*m];
+        for (i = 0; i < n; i++)
+            r[i] = -b[i];
+        for (j = 0; j < n; j++)
+            for (i = 0; i < n; i++)
+                r[i] = r[i] + a[lda*j+i]*xm[j];
+        normx = normr = ZERO;
+        for (i = 0; i < n; i++)
+            {
+            t = (REAL)fabs((double)xm[i]);
+            if (t > normx)
+                normx = t;
+            t = (REAL)fabs((double)r[i]);
+            if (t > normr)
+                normr = t;
+            }
+        t = normr/(norma*normx*n*EPS);
+        if (!(t <= worst))
+            worst = t;
+        }
+    free(r);
+    free(rowsum);
+    return(worst);
+    }
+
+
+/*
+** Reports the scaled residual of each kernel of the mode from the last
+** call to linpack(), and returns nonzero if one is over RESID_LIMIT.
+*/
+static int check(int mode)
+
+    {
+    int k,failed;
+
+    failed = 0;
+    for (k = 0; k < modes[mode].nkernels; k++)
+        {
+        printf("Scaled residual %-8s %10.3f  ",kernel_names[modes[mode].kernels[k]],
+               resid[k]);
+        if (resid[k] >= 0. && resid[k] <= RESID_LIMIT)
+            printf("passed\n");
+        else
+            {
+            printf("FAILED, limit %g\n",RESID_LIMIT);
+            failed = 1;
+            }
+        }
+    return(failed);
+    }
+
+
+/*
+** Sets a and b to the system of matgen.  The first call generates it and
+** keeps a snapshot, which the following calls copy back; without memory
+** for the snapshot, every call generates the system again.
+*/
+static void matset(REAL *a,int lda,int n,REAL *b)
+
+    {
+    REAL norma;
+
+    if (snapshot != NULL && snapshot_n == n)
+        {
+        memcpy(a,snapshot,sizeof(REAL)*lda*n);
+        memcpy(b,&snapshot[(long)lda*n],sizeof(REAL)*n);
+        return;
+        }
+    matgen(a,lda,n,b,&norma);
+    if (snapshot != NULL)
+        {
+        memcpy(snapshot,a,sizeof(REAL)*lda*n);
+        memcpy(&snapshot[(long)lda*n],b,sizeof(REAL)*n);
+        snapshot_n = n;
+        }
+    }
+
+
+/*
+** For matgen,
+** We would like to declare a[][lda], but c does not allow it.  In this
+** function, references to a[i][j] are written a[lda*i+j].
+**
+** The generator init = 3125*init mod 65536 runs through the matrix by
+** columns.  Since its state after k steps is 3125^k*init, lcg_jump() gives
+** the state at the start of any column, or any element, directly, and the
+** matrix is generated by column blocks on gen.nthreads threads, each
+** column GEN_LANES elements at a time from as many states, and b by row
+** blocks.  Every element and every sum of b come out exactly as when
+** generated one after the other.
+*/
+static void matgen(REAL *a,int lda,int n,REAL *b,REAL *norma)
+
+    {
+    pthread_t *thread;
+    REAL      *nmax;
+    long       i,nthreads;
+
+    nthreads = (n/GEN_COLS < gen.nthreads) ? n/GEN_COLS : gen.nthreads;
+    if (nthreads < 1)
+        nthreads = 1;
+    thread = (pthread_t *)malloc(sizeof(pthread_t)*nthreads);
+    nmax = (REAL *)malloc(sizeof(REAL)*nthreads);
+    if (thread == NULL || nmax == NULL)
+        {
+        printf("Not enough memory available for matgen.\n");
+        exit(1);
+        }
+    gen.a = a;
+    gen.b = b;
+    gen.lda = lda;
+    gen.n = n;
+    gen.norma = nmax;
+    pthread_barrier_init(&gen.half,NULL,nthreads);
+    for (i = 1; i < nthreads; i++)
+        if (pthread_create(&thread[i],NULL,matgen_part,(void *)i) != 0)
+            {
+            printf("Cannot create thread %ld.\n",i);
+            exit(1);
+            }
+    matgen_part((void *)0);
+    *norma = 0.0;
+    for (i = 0; i < nthreads; i++)
+        {
+        if (i > 0)
+            pthread_join(thread[i],NULL);
+        *norma = (nmax[i] > *norma) ? nmax[i] : *norma;
+        }
+    pthread_barrier_destroy(&gen.half);
+    free(nmax);
+    free(thread);
+    }
+
+
+static void *matgen_part(void *arg)
+
+    {
+    REAL     *a,*b;
+    REAL      norma;
+    unsigned  state[GEN_LANES],step;
+    int       id,nthreads,lda,n,i,j,l,j0,j1,i0,i1;
+
+    id = (int)(long)arg;
+    a = gen.a;
+    b = gen.b;
+    lda = gen.lda;
+    n = gen.n;
+    nthreads = (n/GEN_COLS < gen.nthreads) ? n/GEN_COLS : gen.nthreads;
+    if (nthreads < 1)
+        nthreads = 1;
+    j0 = (int)((long)n*id/nthreads);
+    j1 = (int)((long)n*(id+1)/nthreads);
+    step = (unsigned)lcg_jump(1,GEN_LANES);
+    norma = 0.0;
+    for (j = j0; j < j1; j++)
+        {
+        state[0] = (unsigned)lcg_jump(1325,(long)n*j+1);
+        for (l = 1; l < GEN_LANES; l++)
+            state[l] = state[l-1]*3125u & 0xffffu;
+        for (i = 0; i + GEN_LANES <= n; i += GEN_LANES)
+            for (l = 0; l < GEN_LANES; l++)
+                {
+                a[lda*j+i+l] = ((int)state[l] - 32768.0)/16384.0;
+                state[l] = state[l]*step & 0xffffu;
+                }
+        for (l = 0; i < n; i++, l++)
+            a[lda*j+i] = ((int)state[l] - 32768.0)/16384.0;
+        for (i = 0; i < n; i++)
+            norma = (a[lda*j+i] > norma) ? a[lda*j+i] : norma;
+        }
+    gen.norma[id] = norma;
+    pthread_barrier_wait(&gen.half);
+    i0 = (int)((long)n*id/nthreads);
+    i1 = (int)((long)n*(id+1)/nthreads);
+    for (i = i0; i < i1; i++)
+        b[i] = 0.0;
+    for (j = 0; j < n; j++)
+        for (i = i0; i < i1; i++)
+            b[i] = b[i] + a[lda*j+i];
+    return(NULL);
+    }
+
+
+/*
+** State of the generator of matgen k steps after init: 3125^k*init mod
+** 65536, by repeated squaring.
+*/
+static int lcg_jump(int init,long k)
+
+    {
+    unsigned long s,m;
+
+    s = (unsigned long)init;
+    m = 3125;
+    for (; k > 0; k >>= 1)
+        {
+        if (k & 1)
+            s = s*m % 65536;
+        m = m*m % 65536;
+        }
+    return((int)s);
     }
 
 
-static REAL linpack(long nreps,int arsize)
+/*
+** matgen for count matrices of order n, stored one after the other by
+** groups of lanes interleaved matrices: element i,j of matrix m is at
+** a[((m/lanes)*n*n+n*j+i)*lanes+m%lanes], and element i of its right-hand
+** side at b[((m/lanes)*n+i)*lanes+m%lanes].  With lanes 1 the matrices are
+** simply consecutive.  The generator runs on from one matrix to the next,
+** skipping one number in between so that the matrices differ for every n.
+*/
+static void matgen_v(REAL *a,int n,int count,int lanes,REAL *b)
 
     {
-    REAL  *a,*b;
-    REAL   norma,t1,kflops,tdgesl,tdgefa,totalt,toverhead,ops;
-    int   *ipvt,n,info,lda;
-    long   i,arsize2d;
+    REAL *am,*bm;
+    int init,i,j,m;
 
-    lda = arsize;
-    n = arsize/2;
-    arsize2d = (long)arsize*(long)arsize;
-    ops=((2.0*n*n*n)/3.0+2.0*n*n);
-    a=(REAL *)mempool;
-    b=a+arsize2d;
-    ipvt=(int *)&b[arsize];
-    tdgesl=0;
-    tdgefa=0;
-    totalt=second();
-    for (i=0;i<nreps;i++)
-        {
-        matgen(a,lda,n,b,&norma);
-        t1 = second();
-        dgefa(a,lda,n,ipvt,&info,1);
-        tdgefa += second()-t1;
-        t1 = second();
-        dgesl(a,lda,n,ipvt,b,0,1);
-        tdgesl += second()-t1;
-        }
-    for (i=0;i<nreps;i++)
-        {
-        matgen(a,lda,n,b,&norma);
-        t1 = second();
-        dgefa(a,lda,n,ipvt,&info,0);
-        tdgefa += second()-t1;
-        t1 = second();
-        dgesl(a,lda,n,ipvt,b,0,0);
-        tdgesl += second()-t1;
+    init = 1325;
+    for (m = 0; m < count; m++)
+        {
+        am = &a[(long)(m/lanes)*n*n*lanes+m%lanes];
+        bm = &b[(long)(m/lanes)*n*lanes+m%lanes];
+        for (i = 0; i < n; i++)
+            bm[lanes*i] = ZERO;
+        for (j = 0; j < n; j++)
+            for (i = 0; i < n; i++)
+                {
+                init = (int)((long)3125*(long)init % 65536L);
+                am[lanes*(n*j+i)] = (init - 32768.0)/16384.0;
+                bm[lanes*i] = bm[lanes*i] + am[lanes*(n*j+i)];
+                }
+        init = (int)((long)3125*(long)init % 65536L);
         }
-    totalt=second()-totalt;
-    if (totalt<0.5 || tdgefa+tdgesl<0.2)
-        return(0.);
-    kflops=2.*nreps*ops/(1000.*(tdgefa+tdgesl));
-    toverhead=totalt-tdgefa-tdgesl;
-    if (tdgefa<0.)
-        tdgefa=0.;
-    if (tdgesl<0.)
-        tdgesl=0.;
-    if (toverhead<0.)
-        toverhead=0.;
-    printf("%8ld %6.2f %6.2f%% %6.2f%% %6.2f%%  %9.3f\n",
-            nreps,totalt,100.*tdgefa/totalt,
-            100.*tdgesl/totalt,100.*toverhead/totalt,
-            kflops);
-    return(totalt);
     }
 
 
 /*
-** For matgen,
-** We would like to declare a[][lda], but c does not allow it.  In this
-** function, references to a[i][j] are written a[lda*i+j].
+** Largest scaled residual of the count solutions x, laid out as b, of the
+** systems of matgen_v.  Leaves a and b regenerated.
 */
-static void matgen(REAL *a,int lda,int n,REAL *b,REAL *norma)
+static REAL residual_v(REAL *a,int n,int count,int lanes,REAL *b,REAL *x)
 
     {
-    int init,i,j;
-
-    init = 1325;
-    *norma = 0.0;
-    for (j = 0; j < n; j++)
+    REAL  *am,*bm,*xm;
+    REAL   norma,normx,normr,t,worst;
+    double rowsum;
+    int    i,j,m;
+
+    matgen_v(a,n,count,lanes,b);
+    worst = ZERO;
+    for (m = 0; m < count; m++)
+        {
+        am = &a[(long)(m/lanes)*n*n*lanes+m%lanes];
+        bm = &b[(long)(m/lanes)*n*lanes+m%lanes];
+        xm = &x[(long)(m/lanes)*n*lanes+m%lanes];
+        norma = normx = normr = ZERO;
         for (i = 0; i < n; i++)
             {
-            init = (int)((long)3125*(long)init % 65536L);
-            a[lda*j+i] = (init - 32768.0)/16384.0;
-            *norma = (a[lda*j+i] > *norma) ? a[lda*j+i] : *norma;
+            t = -bm[lanes*i];
+            rowsum = 0.0;
+            for (j = 0; j < n; j++)
+                {
+                t = t + am[lanes*(n*j+i)]*xm[lanes*j];
+                rowsum = rowsum + fabs((double)am[lanes*(n*j+i)]);
+                }
+            if (rowsum > norma)
+                norma = (REAL)rowsum;
+            if (fabs((double)t) > normr)
+                normr = (REAL)fabs((double)t);
+            if (fabs((double)xm[lanes*i]) > normx)
+                normx = (REAL)fabs((double)xm[lanes*i]);
             }
-    for (i = 0; i < n; i++)
-        b[i] = 0.0;
-    for (j = 0; j < n; j++)
-        for (i = 0; i < n; i++)
-            b[i] = b[i] + a[lda*j+i];
+        t = normr/(norma*normx*n*EPS);
+        if (!(t <= worst))
+            worst = t;
+        }
+    return(worst);
     }
 
 
@@ -273,7 +1480,7 @@ static void matgen(REAL *a,int lda,int n,REAL *b,REAL *norma)
 **   blas daxpy,dscal,idamax
 **
 */
-static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int roll)
+static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int kernel)
 
     {
     REAL t;
@@ -281,7 +1488,7 @@ static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int roll)
 
     /* gaussian elimination with partial pivoting */
 
-    if (roll)
+    if (kernel == ROLLED)
         {
         *info = 0;
         nm1 = n - 1;
@@ -335,7 +1542,7 @@ static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int roll)
         if (a[lda*(n-1)+(n-1)] == ZERO)
             (*info) = n-1;
         }
-    else
+    else if (kernel == UNROLLED)
         {
         *info = 0;
         nm1 = n - 1;
@@ -389,7 +1596,328 @@ static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int roll)
         if (a[lda*(n-1)+(n-1)] == ZERO)
             (*info) = n-1;
         }
+    else
+        {
+        *info = 0;
+        nm1 = n - 1;
+        if (nm1 >=  0)
+            for (k = 0; k < nm1; k++)
+                {
+                kp1 = k + 1;
+
+                /* find l = pivot index */
+
+                l = idamax_s(n-k,&a[lda*k+k],1) + k;
+                ipvt[k] = l;
+
+                /* zero pivot implies this column already
+                   triangularized */
+
+                if (a[lda*k+l] != ZERO)
+                    {
+
+                    /* interchange if necessary */
+
+                    if (l != k)
+                        {
+                        t = a[lda*k+l];
+                        a[lda*k+l] = a[lda*k+k];
+                        a[lda*k+k] = t;
+                        }
+
+                    /* compute multipliers */
+
+                    t = -ONE/a[lda*k+k];
+                    dscal_s(n-(k+1),t,&a[lda*k+k+1],1);
+
+                    /* row elimination with column indexing */
+
+                    for (j = kp1; j < n; j++)
+                        {
+                        t = a[lda*j+l];
+                        if (l != k)
+                            {
+                            a[lda*j+l] = a[lda*j+k];
+                            a[lda*j+k] = t;
+                            }
+                        daxpy_s(n-(k+1),t,&a[lda*k+k+1],1,&a[lda*j+k+1],1);
+                        }
+                    }
+                else
+                    (*info) = k;
+                }
+        ipvt[n-1] = n-1;
+        if (a[lda*(n-1)+(n-1)] == ZERO)
+            (*info) = n-1;
+        }
+    }
+
+
+/*
+** Blocked LU factorization with partial pivoting.
+**
+** dgefa_b leaves the same factors as dgefa: the same pivots in ipvt and
+** the same upper triangle and negated multipliers in a, so dgesl solves
+** with them unchanged.  It works on panels of NB columns.  dpanel_b
+** factors a panel, interchanging whole rows of the panel so that its
+** multipliers stay in step with the rows below it.  dupdate_b applies the
+** panel to the columns on its right: the interchanges, the unit lower
+** triangle, which gives NB rows of u, and the rank-NB update of the
+** trailing matrix a22 += l21*u12 by dgemm_b.  Last, dorder_b undoes the
+** interchanges in the multiplier columns of the panel, which dgefa never
+** swaps.
+*/
+static void dgefa_b(REAL *a,int lda,int n,int *ipvt,int *info)
+
+    {
+    int k0,kend;
+
+    *info = 0;
+    for (k0 = 0; k0 < n; k0 += NB)
+        {
+        kend = (n - k0 < NB) ? n : k0 + NB;
+        dpanel_b(a,lda,n,k0,kend,ipvt,info,packbuf);
+        dupdate_b(a,lda,n,k0,kend,kend,n,ipvt,packbuf);
+        dorder_b(a,lda,k0,kend,ipvt);
+        }
+    }
+
+
+/*
+** Parallel blocked LU factorization, same factors as dgefa_b.  At each
+** step the master thread first brings the next panel up to date and
+** factors it (lookahead), then joins the threads of the pool, which
+** meanwhile share the update of the rest of the trailing matrix by the
+** current panel.  The multipliers are put back in the order of dgefa
+** once all steps are done, since the threads read them until then.
+*/
+static void dgefa_p(REAL *a,int lda,int n,int *ipvt,int *info)
+
+    {
+    int k0,k1,k2;
+
+    *info = 0;
+    pool.a = a;
+    pool.lda = lda;
+    pool.n = n;
+    pool.ipvt = ipvt;
+    k1 = (n < NB) ? n : NB;
+    dpanel_b(a,lda,n,0,k1,ipvt,info,pool.work[0]);
+    for (k0 = 0; k0 < n; k0 = k1)
+        {
+        k1 = (n - k0 < NB) ? n : k0 + NB;
+        k2 = (n - k1 < NB) ? n : k1 + NB;
+        pool.k0 = k0;
+        pool.k1 = k1;
+        pool.next = k2;
+        pthread_barrier_wait(&pool.start);
+        dupdate_b(a,lda,n,k0,k1,k1,k2,ipvt,pool.work[0]);
+        if (k1 < n)
+            dpanel_b(a,lda,n,k1,k2,ipvt,info,pool.work[0]);
+        pool_update(0);
+        pthread_barrier_wait(&pool.done);
+        }
+    for (k0 = 0; k0 < n; k0 += NB)
+        dorder_b(a,lda,k0,(n - k0 < NB) ? n : k0 + NB,ipvt);
+    }
+
+
+/*
+** Factors columns k0 to k1-1 of a, from row k0 down, interchanging whole
+** rows of these columns.  Panels wider than NBMIN are split in two halves
+** and factored recursively, the left half updating the right one through
+** dupdate_b, so that most of the work of a panel is done by dgemm_b too.
+*/
+static void dpanel_b(REAL *a,int lda,int n,int k0,int k1,int *ipvt,int *info,
+                     REAL *work)
+
+    {
+    REAL t;
+    int j,k,l,mid;
+
+    if (k1 - k0 > NBMIN)
+        {
+        mid = k0 + (k1 - k0)/2;
+        dpanel_b(a,lda,n,k0,mid,ipvt,info,work);
+        dupdate_b(a,lda,n,k0,mid,mid,k1,ipvt,work);
+        dpanel_b(a,lda,n,mid,k1,ipvt,info,work);
+        dlaswp_b(a,lda,k0,mid,mid,k1,ipvt);
+        return;
+        }
+    for (k = k0; k < k1; k++)
+        {
+        l = idamax_s(n-k,&a[lda*k+k],1) + k;
+        ipvt[k] = l;
+
+        /* zero pivot implies this column already
+           triangularized */
+
+        if (a[lda*k+l] == ZERO)
+            {
+            (*info) = k;
+            continue;
+            }
+        if (l != k)
+            for (j = k0; j < k1; j++)
+                {
+                t = a[lda*j+l];
+                a[lda*j+l] = a[lda*j+k];
+                a[lda*j+k] = t;
+                }
+        t = -ONE/a[lda*k+k];
+        dscal_s(n-(k+1),t,&a[lda*k+k+1],1);
+        for (j = k+1; j < k1; j++)
+            daxpy_s(n-(k+1),a[lda*j+k],&a[lda*k+k+1],1,&a[lda*j+k+1],1);
+        }
+    }
+
+
+/*
+** Applies the factored columns k0 to k1-1 to columns j0 to j1-1 on their
+** right: their interchanges, their unit lower triangle, which leaves rows
+** k0 to k1-1 of u, and the update of the rows below by dgemm_b.  Disjoint
+** column ranges can be updated concurrently, with separate work buffers.
+*/
+static void dupdate_b(REAL *a,int lda,int n,int k0,int k1,int j0,int j1,
+                      int *ipvt,REAL *work)
+
+    {
+    int j,k;
+
+    if (j0 >= j1)
+        return;
+    dlaswp_b(a,lda,j0,j1,k0,k1,ipvt);
+    for (j = j0; j < j1; j++)
+        for (k = k0; k < k1; k++)
+            daxpy_s(k1-(k+1),a[lda*j+k],&a[lda*k+k+1],1,&a[lda*j+k+1],1);
+    dgemm_b(n-k1,j1-j0,k1-k0,&a[lda*k0+k1],lda,&a[lda*j0+k0],lda,
+            &a[lda*j0+k1],lda,work);
+    }
+
+
+/*
+** Interchanges rows k and ipvt[k] of columns j0 to j1-1, for k from k0 to
+** k1-1, skipping the zero pivots that dgefa does not interchange.
+*/
+static void dlaswp_b(REAL *a,int lda,int j0,int j1,int k0,int k1,int *ipvt)
+
+    {
+    REAL t;
+    int j,k,l;
+
+    for (j = j0; j < j1; j++)
+        for (k = k0; k < k1; k++)
+            {
+            l = ipvt[k];
+            if (l != k && a[lda*k+k] != ZERO)
+                {
+                t = a[lda*j+l];
+                a[lda*j+l] = a[lda*j+k];
+                a[lda*j+k] = t;
+                }
+            }
+    }
+
+
+/*
+** Undoes the interchanges of pivots k0+1 to k1-1 in the multiplier
+** columns k0 to k1-2 on their left, which leaves them in the row order
+** of dgefa.
+*/
+static void dorder_b(REAL *a,int lda,int k0,int k1,int *ipvt)
+
+    {
+    REAL t;
+    int j,k,l;
+
+    for (k = k1-1; k > k0; k--)
+        {
+        l = ipvt[k];
+        if (l != k && a[lda*k+k] != ZERO)
+            for (j = k0; j < k; j++)
+                {
+                t = a[lda*j+l];
+                a[lda*j+l] = a[lda*j+k];
+                a[lda*j+k] = t;
+                }
+        }
+    }
+
+
+/*
+** c += a*b, where c is m x n, a is m x k with k <= NB, and all three are
+** stored by columns.  b is copied NC columns at a time into packb as
+** slivers of NR columns, a is copied MC rows at a time into packa as
+** slivers of mr rows, each laid out in the order the register tile of
+** dgemm_kernel_s reads it.
+** Slivers at the edges are padded with zeros.  packa and packb share the
+** PACKSIZE elements of work.
+*/
+static void dgemm_b(int m,int n,int k,REAL *a,int lda,REAL *b,int ldb,
+                    REAL *c,int ldc,REAL *work)
+
+    {
+    REAL *p,*packa,*packb;
+    int i,j,l,ic,jc,ir,jr,mc,nc;
+
+    packa = work;
+    packb = work + MC*NB+MRMAX*NB;
+    for (jc = 0; jc < n; jc += NC)
+        {
+        nc = (n - jc < NC) ? n - jc : NC;
+        p = packb;
+        for (jr = 0; jr < nc; jr += NR)
+            for (l = 0; l < k; l++)
+                for (j = 0; j < NR; j++)
+                    *p++ = (jr + j < nc) ? b[ldb*(jc+jr+j)+l] : ZERO;
+        for (ic = 0; ic < m; ic += MC)
+            {
+            mc = (m - ic < MC) ? m - ic : MC;
+            p = packa;
+            for (ir = 0; ir < mc; ir += mr)
+                for (l = 0; l < k; l++)
+                    for (i = 0; i < mr; i++)
+                        *p++ = (ir + i < mc) ? a[lda*l+ic+ir+i] : ZERO;
+            for (jr = 0; jr < nc; jr += NR)
+                for (ir = 0; ir < mc; ir += mr)
+                    dgemm_kernel_s(k,&packa[ir*k],&packb[jr*k],
+                                   &c[ldc*(jc+jr)+ic+ir],ldc,
+                                   (mc - ir < mr) ? mc - ir : mr,
+                                   (nc - jr < NR) ? nc - jr : NR);
+            }
+        }
+    }
+
+
+/*
+** Register tile of dgemm_b without GNU C vectors: the MR x NR block of c
+** at c[0] gets the product of an MR row sliver of packa and an NR column
+** sliver of packb, of which only the leading m x n part is stored back.
+** With GNU C it comes from linpack_gemm.h.
+*/
+#ifndef __GNUC__
+static void dgemm_kernel(int k,REAL *pa,REAL *pb,REAL *c,int ldc,int m,int n)
+
+    {
+    REAL ab[NR][MR];
+    int i,j,l;
+
+    for (j = 0; j < NR; j++)
+        for (i = 0; i < MR; i++)
+            ab[j][i] = ZERO;
+    for (l = 0; l < k; l++)
+        {
+        for (j = 0; j < NR; j++)
+            for (i = 0; i < MR; i++)
+                ab[j][i] += pa[i]*pb[j];
+        pa += MR;
+        pb += NR;
+        }
+    for (j = 0; j < n; j++)
+        for (i = 0; i < m; i++)
+            c[ldc*j+i] += ab[j][i];
     }
+#endif
 
 
 /*
@@ -453,13 +1981,74 @@ static void dgefa(REAL *a,int lda,int n,int *ipvt,int *info,int roll)
 **
 **   blas daxpy,ddot
 */
-static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
+static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int kernel)
 
     {
     REAL    t;
     int     k,kb,l,nm1;
 
-    if (roll)
+    if (kernel == ROLLED)
+        {
+        nm1 = n - 1;
+        if (job == 0)
+            {
+
+            /* job = 0 , solve  a * x = b   */
+            /* first solve  l*y = b         */
+
+            if (nm1 >= 1)
+                for (k = 0; k < nm1; k++)
+                    {
+                    l = ipvt[k];
+                    t = b[l];
+                    if (l != k)
+                        {
+                        b[l] = b[k];
+                        b[k] = t;
+                        }
+                    daxpy_r(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
+                    }
+
+            /* now solve  u*x = y */
+
+            for (kb = 0; kb < n; kb++)
+                {
+                k = n - (kb + 1);
+                b[k] = b[k]/a[lda*k+k];
+                t = -b[k];
+                daxpy_r(k,t,&a[lda*k+0],1,&b[0],1);
+                }
+            }
+        else
+            {
+
+            /* job = nonzero, solve  trans(a) * x = b  */
+            /* first solve  trans(u)*y = b             */
+
+            for (k = 0; k < n; k++)
+                {
+                t = ddot_r(k,&a[lda*k+0],1,&b[0],1);
+                b[k] = (b[k] - t)/a[lda*k+k];
+                }
+
+            /* now solve trans(l)*x = y     */
+
+            if (nm1 >= 1)
+                for (kb = 1; kb < nm1; kb++)
+                    {
+                    k = n - (kb+1);
+                    b[k] = b[k] + ddot_r(n-(k+1),&a[lda*k+k+1],1,&b[k+1],1);
+                    l = ipvt[k];
+                    if (l != k)
+                        {
+                        t = b[l];
+                        b[l] = b[k];
+                        b[k] = t;
+                        }
+                    }
+            }
+        }
+    else if (kernel == UNROLLED)
         {
         nm1 = n - 1;
         if (job == 0)
@@ -478,7 +2067,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                         b[l] = b[k];
                         b[k] = t;
                         }
-                    daxpy_r(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
+                    daxpy_ur(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
                     }
 
             /* now solve  u*x = y */
@@ -488,7 +2077,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                 k = n - (kb + 1);
                 b[k] = b[k]/a[lda*k+k];
                 t = -b[k];
-                daxpy_r(k,t,&a[lda*k+0],1,&b[0],1);
+                daxpy_ur(k,t,&a[lda*k+0],1,&b[0],1);
                 }
             }
         else
@@ -499,7 +2088,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
 
             for (k = 0; k < n; k++)
                 {
-                t = ddot_r(k,&a[lda*k+0],1,&b[0],1);
+                t = ddot_ur(k,&a[lda*k+0],1,&b[0],1);
                 b[k] = (b[k] - t)/a[lda*k+k];
                 }
 
@@ -509,7 +2098,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                 for (kb = 1; kb < nm1; kb++)
                     {
                     k = n - (kb+1);
-                    b[k] = b[k] + ddot_r(n-(k+1),&a[lda*k+k+1],1,&b[k+1],1);
+                    b[k] = b[k] + ddot_ur(n-(k+1),&a[lda*k+k+1],1,&b[k+1],1);
                     l = ipvt[k];
                     if (l != k)
                         {
@@ -539,7 +2128,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                         b[l] = b[k];
                         b[k] = t;
                         }
-                    daxpy_ur(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
+                    daxpy_s(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
                     }
 
             /* now solve  u*x = y */
@@ -549,7 +2138,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                 k = n - (kb + 1);
                 b[k] = b[k]/a[lda*k+k];
                 t = -b[k];
-                daxpy_ur(k,t,&a[lda*k+0],1,&b[0],1);
+                daxpy_s(k,t,&a[lda*k+0],1,&b[0],1);
                 }
             }
         else
@@ -560,7 +2149,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
 
             for (k = 0; k < n; k++)
                 {
-                t = ddot_ur(k,&a[lda*k+0],1,&b[0],1);
+                t = ddot_s(k,&a[lda*k+0],1,&b[0],1);
                 b[k] = (b[k] - t)/a[lda*k+k];
                 }
 
@@ -570,7 +2159,7 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
                 for (kb = 1; kb < nm1; kb++)
                     {
                     k = n - (kb+1);
-                    b[k] = b[k] + ddot_ur(n-(k+1),&a[lda*k+k+1],1,&b[k+1],1);
+                    b[k] = b[k] + ddot_s(n-(k+1),&a[lda*k+k+1],1,&b[k+1],1);
                     l = ipvt[k];
                     if (l != k)
                         {
@@ -585,6 +2174,250 @@ static void dgesl(REAL *a,int lda,int n,int *ipvt,REAL *b,int job,int roll)
 
 
 
+/*
+** Solves a*x = b for the nrhs columns of b at once (leading dimension
+** ldb), with the factors of dgefa or dgefa_b, leaving x in b.  The
+** triangles are taken NB columns at a time: each block is applied to its
+** own NB rows of b column by column, and to all the rows below (l) or
+** above (u) by one dgemm_b, which does most of the work as a matrix
+** product with the nrhs columns.  For the products with l the multipliers
+** of a block are put in the row order of the interchanges of the whole
+** block by dreorder_b, and restored by dorder_b.
+*/
+static void dgesl_m(REAL *a,int lda,int n,int *ipvt,REAL *b,int ldb,int nrhs)
+
+    {
+    REAL t;
+    int j,k,l,k0,k1;
+
+    /* solve l*y = b */
+
+    for (k0 = 0; k0 < n; k0 += NB)
+        {
+        k1 = (n - k0 < NB) ? n : k0 + NB;
+        dreorder_b(a,lda,k0,k1,ipvt);
+        for (j = 0; j < nrhs; j++)
+            for (k = k0; k < k1; k++)
+                {
+                l = ipvt[k];
+                t = b[(long)ldb*j+l];
+                if (l != k)
+                    {
+                    b[(long)ldb*j+l] = b[(long)ldb*j+k];
+                    b[(long)ldb*j+k] = t;
+                    }
+                }
+        for (j = 0; j < nrhs; j++)
+            for (k = k0; k < k1; k++)
+                daxpy_s(k1-(k+1),b[(long)ldb*j+k],&a[lda*k+k+1],1,
+                        &b[(long)ldb*j+k+1],1);
+        dgemm_b(n-k1,nrhs,k1-k0,&a[lda*k0+k1],lda,&b[k0],ldb,&b[k1],ldb,
+                packbuf);
+        dorder_b(a,lda,k0,k1,ipvt);
+        }
+
+    /* solve u*x = y, with the solved rows negated for dgemm_b */
+
+    for (k1 = n; k1 > 0; k1 = k0)
+        {
+        k0 = (k1 - 1)/NB*NB;
+        for (j = 0; j < nrhs; j++)
+            {
+            for (k = k1-1; k >= k0; k--)
+                {
+                b[(long)ldb*j+k] = b[(long)ldb*j+k]/a[lda*k+k];
+                daxpy_s(k-k0,-b[(long)ldb*j+k],&a[lda*k+k0],1,&b[(long)ldb*j+k0],1);
+                }
+            dscal_s(k1-k0,-ONE,&b[(long)ldb*j+k0],1);
+            }
+        dgemm_b(k0,nrhs,k1-k0,&a[lda*k0],lda,&b[k0],ldb,&b[0],ldb,packbuf);
+        for (j = 0; j < nrhs; j++)
+            dscal_s(k1-k0,-ONE,&b[(long)ldb*j+k0],1);
+        }
+    }
+
+
+/*
+** Inverse of dorder_b: redoes the interchanges of pivots k0+1 to k1-1 in
+** the multiplier columns k0 to k1-2 on their left, as dpanel_b left them.
+*/
+static void dreorder_b(REAL *a,int lda,int k0,int k1,int *ipvt)
+
+    {
+    REAL t;
+    int j,k,l;
+
+    for (k = k0+1; k < k1; k++)
+        {
+        l = ipvt[k];
+        if (l != k && a[lda*k+k] != ZERO)
+            for (j = k0; j < k; j++)
+                {
+                t = a[lda*j+l];
+                a[lda*j+l] = a[lda*j+k];
+                a[lda*j+k] = t;
+                }
+        }
+    }
+
+
+#ifdef DP
+/*
+** Mixed precision factorization: rounds a to single precision into sa,
+** with the same leading dimension, and factors sa with sgefa.  a is left
+** unchanged for the residuals of dsgesl.
+*/
+static void dsgefa(REAL *a,int lda,int n,float *sa,int *ipvt,int *info)
+
+    {
+    int i,j;
+
+    for (j = 0; j < n; j++)
+        for (i = 0; i < n; i++)
+            sa[lda*j+i] = (float)a[lda*j+i];
+    sgefa(sa,lda,n,ipvt,info);
+    }
+
+
+/*
+** Mixed precision solve of a*x = b by iterative refinement, as in LAPACK
+** dsgesv.  The single precision factors sa of dsgefa give a first x; then
+** as long as the residual r = b-a*x, computed in double precision with the
+** original a, is over sqrt(n)*||a||*||x||*eps in the infinity norm, sgesl
+** solves a*d = r and x += d.  Each step costs 2n^2 double and 2n^2 single
+** precision flops, against 2n^3/3 for the factorization.  After
+** MIXED_ITMAX steps the last x is kept, and fails the residual check.
+**
+** On return b holds x.  sb is n floats of work, work 2*n REAL.  Returns the
+** number of refinement steps.
+*/
+static int dsgesl(REAL *a,int lda,int n,float *sa,int *ipvt,REAL *b,
+                  float *sb,REAL *work)
+
+    {
+    REAL *x,*r;
+    REAL norma,normx,normr,t;
+    int  i,j,step;
+
+    x = work;
+    r = work + n;
+    for (i = 0; i < n; i++)
+        r[i] = ZERO;
+    for (j = 0; j < n; j++)
+        for (i = 0; i < n; i++)
+            r[i] = r[i] + fabs(a[lda*j+i]);
+    norma = ZERO;
+    for (i = 0; i < n; i++)
+        if (r[i] > norma)
+            norma = r[i];
+    for (i = 0; i < n; i++)
+        sb[i] = (float)b[i];
+    sgesl(sa,lda,n,ipvt,sb);
+    for (i = 0; i < n; i++)
+        x[i] = sb[i];
+    for (step = 0; ; step++)
+        {
+        for (i = 0; i < n; i++)
+            r[i] = b[i];
+        for (j = 0; j < n; j++)
+            daxpy_s(n,-x[j],&a[lda*j],1,r,1);
+        normx = normr = ZERO;
+        for (i = 0; i < n; i++)
+            {
+            t = fabs(x[i]);
+            if (t > normx)
+                normx = t;
+            t = fabs(r[i]);
+            if (t > normr)
+                normr = t;
+            }
+        if (normr <= sqrt((double)n)*norma*normx*EPS || step == MIXED_ITMAX)
+            break;
+        for (i = 0; i < n; i++)
+            sb[i] = (float)r[i];
+        sgesl(sa,lda,n,ipvt,sb);
+        for (i = 0; i < n; i++)
+            x[i] = x[i] + sb[i];
+        }
+    for (i = 0; i < n; i++)
+        b[i] = x[i];
+    return(step);
+    }
+
+
+/*
+** Single precision dgefa and dgesl (job = 0) of the mixed precision mode,
+** with the vectorized kernels: twice the elements per vector, and half the
+** memory traffic, of double precision.
+*/
+static void sgefa(float *a,int lda,int n,int *ipvt,int *info)
+
+    {
+    float t;
+    int j,k,l;
+
+    *info = 0;
+    for (k = 0; k < n-1; k++)
+        {
+        l = isamax_s(n-k,&a[lda*k+k],1) + k;
+        ipvt[k] = l;
+        if (a[lda*k+l] == 0.0f)
+            {
+            *info = k;
+            continue;
+            }
+        if (l != k)
+            {
+            t = a[lda*k+l];
+            a[lda*k+l] = a[lda*k+k];
+            a[lda*k+k] = t;
+            }
+        t = -1.0f/a[lda*k+k];
+        sscal_s(n-(k+1),t,&a[lda*k+k+1],1);
+        for (j = k+1; j < n; j++)
+            {
+            t = a[lda*j+l];
+            if (l != k)
+                {
+                a[lda*j+l] = a[lda*j+k];
+                a[lda*j+k] = t;
+                }
+            saxpy_s(n-(k+1),t,&a[lda*k+k+1],1,&a[lda*j+k+1],1);
+            }
+        }
+    ipvt[n-1] = n-1;
+    if (a[lda*(n-1)+(n-1)] == 0.0f)
+        *info = n-1;
+    }
+
+
+static void sgesl(float *a,int lda,int n,int *ipvt,float *b)
+
+    {
+    float t;
+    int   k,l;
+
+    for (k = 0; k < n-1; k++)
+        {
+        l = ipvt[k];
+        t = b[l];
+        if (l != k)
+            {
+            b[l] = b[k];
+            b[k] = t;
+            }
+        saxpy_s(n-(k+1),t,&a[lda*k+k+1],1,&b[k+1],1);
+        }
+    for (k = n-1; k >= 0; k--)
+        {
+        b[k] = b[k]/a[lda*k+k];
+        t = -b[k];
+        saxpy_s(k,t,&a[lda*k+0],1,&b[0],1);
+        }
+    }
+#endif
+
+
 /*
 ** Constant times a vector plus a vector.
 ** Jack Dongarra, linpack, 3/11/78.
@@ -867,7 +2700,8 @@ static int idamax(int n,REAL *dx,int incx)
 
         /* code for increment not equal to 1 */
 
-        ix = 1;
+        itemp = 0;
+        ix = 0;
         dmax = fabs((double)dx[0]);
         ix = ix + incx;
         for (i = 1; i < n; i++)
@@ -898,10 +2732,400 @@ static int idamax(int n,REAL *dx,int incx)
     }
 
 
-static REAL second(void)
+#ifdef DP
+/*
+** Single precision daxpy, dscal and idamax, rolled, behind the vectorized
+** ones of the mixed precision mode.
+*/
+static void saxpy_r(int n,float da,float *dx,int incx,float *dy,int incy)
+
+    {
+    int i;
+
+    if (n <= 0 || da == 0.0f)
+        return;
+    if (incx < 0)
+        dx += (1-n)*incx;
+    if (incy < 0)
+        dy += (1-n)*incy;
+    for (i = 0; i < n; i++)
+        dy[i*incy] = dy[i*incy] + da*dx[i*incx];
+    }
+
+
+static void sscal_r(int n,float da,float *dx,int incx)
+
+    {
+    int i;
+
+    for (i = 0; i < n; i++)
+        dx[i*incx] = da*dx[i*incx];
+    }
+
+
+static int isamax(int n,float *dx,int incx)
+
+    {
+    float dmax;
+    int   i,itemp;
+
+    if (n < 1)
+        return(-1);
+    itemp = 0;
+    dmax = fabsf(dx[0]);
+    for (i = 1; i < n; i++)
+        if (fabsf(dx[i*incx]) > dmax)
+            {
+            itemp = i;
+            dmax = fabsf(dx[i*incx]);
+            }
+    return(itemp);
+    }
+#endif
+
+
+/*
+** Points the SIMD kernels, the register tile of dgemm_b and the batched
+** kernels at the widest instruction set the processor supports, or at a
+** narrower one named by the LINPACK_SIMD environment variable (sse2 or
+** avx2), and returns its name.
+*/
+static char *simd_init(void)
+
+    {
+#ifdef SIMD_X86
+    char *cap;
+    int level;
+
+    __builtin_cpu_init();
+    level = 1;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        level = 2;
+    if (level == 2 && __builtin_cpu_supports("avx512f"))
+        level = 3;
+    cap = getenv("LINPACK_SIMD");
+    if (cap != NULL && strcmp(cap,"sse2") == 0)
+        level = 1;
+    else if (cap != NULL && strcmp(cap,"avx2") == 0 && level > 2)
+        level = 2;
+    if (level == 3)
+        {
+        daxpy_s = daxpy_avx512;
+        ddot_s = ddot_avx512;
+        dscal_s = dscal_avx512;
+        idamax_s = idamax_avx512;
+#ifdef DP
+        saxpy_s = saxpy_avx512;
+        sscal_s = sscal_avx512;
+        isamax_s = isamax_avx512;
+#endif
+        dgemm_kernel_s = dgemm_kernel_avx512;
+        dgefa_v_s = dgefa_v_avx512;
+        dgesl_v_s = dgesl_v_avx512;
+        mr = 2*64/(int)sizeof(REAL);
+        vlanes = 64/(int)sizeof(REAL);
+        return("AVX-512");
+        }
+    if (level == 2)
+        {
+        daxpy_s = daxpy_avx2;
+        ddot_s = ddot_avx2;
+        dscal_s = dscal_avx2;
+        idamax_s = idamax_avx2;
+#ifdef DP
+        saxpy_s = saxpy_avx2;
+        sscal_s = sscal_avx2;
+        isamax_s = isamax_avx2;
+#endif
+        dgemm_kernel_s = dgemm_kernel_avx2;
+        dgefa_v_s = dgefa_v_avx2;
+        dgesl_v_s = dgesl_v_avx2;
+        mr = 2*32/(int)sizeof(REAL);
+        vlanes = 32/(int)sizeof(REAL);
+        return("AVX2 and FMA");
+        }
+    daxpy_s = daxpy_sse2;
+    ddot_s = ddot_sse2;
+    dscal_s = dscal_sse2;
+    idamax_s = idamax_sse2;
+#ifdef DP
+    saxpy_s = saxpy_sse2;
+    sscal_s = sscal_sse2;
+    isamax_s = isamax_sse2;
+#endif
+    dgemm_kernel_s = dgemm_kernel_sse2;
+    dgefa_v_s = dgefa_v_sse2;
+    dgesl_v_s = dgesl_v_sse2;
+    mr = 2*16/(int)sizeof(REAL);
+    vlanes = 16/(int)sizeof(REAL);
+    return("SSE2");
+#else
+    daxpy_s = daxpy_ur;
+    ddot_s = ddot_ur;
+    dscal_s = dscal_ur;
+    idamax_s = idamax;
+#ifdef DP
+    saxpy_s = saxpy_r;
+    sscal_s = sscal_r;
+    isamax_s = isamax;
+#endif
+#ifdef __GNUC__
+    dgemm_kernel_s = dgemm_kernel_gen;
+    dgefa_v_s = dgefa_v_gen;
+    dgesl_v_s = dgesl_v_gen;
+#else
+    dgemm_kernel_s = dgemm_kernel;
+#endif
+    return("none, unrolled kernels");
+#endif
+    }
+
+
+/*
+** Starts nthreads-1 threads next to the calling one, which is thread 0 of
+** the pool.
+*/
+static void pool_start(int nthreads)
+
+    {
+    long i;
+
+    pool.nthreads = nthreads;
+    pool.quit = 0;
+    pool.thread = (pthread_t *)malloc(sizeof(pthread_t)*nthreads);
+    pool.work = (REAL **)malloc(sizeof(REAL *)*nthreads);
+    if (pool.thread == NULL || pool.work == NULL)
+        {
+        printf("Not enough memory available for %d threads.\n",nthreads);
+        exit(1);
+        }
+    for (i = 0; i < nthreads; i++)
+        if ((pool.work[i] = (REAL *)malloc(sizeof(REAL)*PACKSIZE)) == NULL)
+            {
+            printf("Not enough memory available for %d threads.\n",nthreads);
+            exit(1);
+            }
+    pthread_barrier_init(&pool.start,NULL,nthreads);
+    pthread_barrier_init(&pool.done,NULL,nthreads);
+    pthread_mutex_init(&pool.lock,NULL);
+    for (i = 1; i < nthreads; i++)
+        if (pthread_create(&pool.thread[i],NULL,pool_worker,(void *)i) != 0)
+            {
+            printf("Cannot create thread %ld.\n",i);
+            exit(1);
+            }
+    }
+
+
+static void pool_stop(void)
+
+    {
+    int i;
+
+    pool.quit = 1;
+    pthread_barrier_wait(&pool.start);
+    for (i = 1; i < pool.nthreads; i++)
+        pthread_join(pool.thread[i],NULL);
+    pthread_barrier_destroy(&pool.start);
+    pthread_barrier_destroy(&pool.done);
+    pthread_mutex_destroy(&pool.lock);
+    for (i = 0; i < pool.nthreads; i++)
+        free(pool.work[i]);
+    free(pool.work);
+    free(pool.thread);
+    }
+
+
+static void *pool_worker(void *arg)
 
     {
-    return ((REAL)((REAL)clock()/(REAL)CLOCKS_PER_SEC));
+    int id;
+
+    id = (int)(long)arg;
+    while (1)
+        {
+        pthread_barrier_wait(&pool.start);
+        if (pool.quit)
+            break;
+        pool_update(id);
+        pthread_barrier_wait(&pool.done);
+        }
+    return(NULL);
+    }
+
+
+/*
+** Takes chunks of NB columns of the current step until none are left and
+** updates them with the panel pool.k0 to pool.k1-1.
+*/
+static void pool_update(int id)
+
+    {
+    int j0,j1;
+
+    while (1)
+        {
+        pthread_mutex_lock(&pool.lock);
+        j0 = pool.next;
+        pool.next += NB;
+        pthread_mutex_unlock(&pool.lock);
+        if (j0 >= pool.n)
+            break;
+        j1 = (pool.n - j0 < NB) ? pool.n : j0 + NB;
+        dupdate_b(pool.a,pool.lda,pool.n,pool.k0,pool.k1,j0,j1,pool.ipvt,
+                  pool.work[id]);
+        }
+    }
+
+
+/*
+** Opens the hardware counters if LINPACK_COUNTERS is set in the
+** environment, for the calling thread only: in parallel mode the other
+** threads of the pool are not counted.  Returns what is counted, or why
+** nothing is, or NULL if no counters were asked for.  A counter the
+** processor lacks is left out; without any, the phases are still reported
+** with their times.
+*/
+static char *counters_init(void)
+
+    {
+#ifdef COUNTERS
+    static char   desc[80];
+    struct perf_event_attr attr;
+#ifdef SP
+    static int    umask[4] = { 0x02,0x08,0x20,0x80 };
+#else
+    static int    umask[4] = { 0x01,0x04,0x10,0x40 };
+#endif
+#endif
+    int e;
+
+    for (e = 0; e < NCOUNTERS; e++)
+        counter_fd[e] = -1;
+    if (getenv("LINPACK_COUNTERS") == NULL)
+        return(NULL);
+    counters = 1;
+#ifdef COUNTERS
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    counter_fd[CYCLES] = (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+    if (counter_fd[CYCLES] < 0)
+        {
+        sprintf(desc,"unavailable, %.60s",strerror(errno));
+        return(desc);
+        }
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    counter_fd[LLC_MISSES] = (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+#ifdef SIMD_X86
+    if (__builtin_cpu_is("intel"))
+        for (e = 0; e < 4; e++)
+            {
+            attr.type = PERF_TYPE_RAW;
+            attr.config = 0xc7 | (umask[e] << 8);
+            counter_fd[FP_OPS+e] = (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+            }
+#else
+    (void)umask;
+#endif
+    sprintf(desc,"cycles%s%s",(counter_fd[LLC_MISSES] >= 0) ? ", LLC misses" : "",
+            (counter_fd[FP_OPS] >= 0) ? ", FP operations" : "");
+    return(desc);
+#else
+    return("unavailable on this system");
+#endif
+    }
+
+
+/*
+** Current value of every counter, scaled up for the time it was not
+** counting if the kernel had to share the hardware; -1 if not open.
+*/
+static void counters_read(long long *count)
+
+    {
+    int e;
+#ifdef COUNTERS
+    unsigned long long v[3];
+
+    for (e = 0; e < NCOUNTERS; e++)
+        {
+        count[e] = -1;
+        if (counter_fd[e] < 0 || read(counter_fd[e],v,sizeof(v)) != sizeof(v))
+            continue;
+        count[e] = (v[2] > 0 && v[2] < v[1]) ? (long long)((double)v[0]*v[1]/v[2])
+                                             : (long long)v[0];
+        }
+#else
+    for (e = 0; e < NCOUNTERS; e++)
+        count[e] = -1;
+#endif
+    }
+
+
+/*
+** Prints for both phases of each kernel of the mode, in the last call to
+** linpack(): GFLOPS, FLOP/cycle of the operation count of the benchmark,
+** FP operations retired per cycle, LLC misses, and the memory traffic per
+** flop they amount to.  Counters not available print as -.
+*/
+static void counters_report(int mode)
+
+    {
+    static char *names[2] = { "DGEFA","DGESL" };
+#ifdef SP
+    static int   width[4] = { 1,4,8,16 };
+#else
+    static int   width[4] = { 1,2,4,8 };
+#endif
+    long long *c;
+    double     fpops;
+    int        k,p,e;
+
+    printf("\nKernel   Phase    GFLOPS FLOP/cycle FP ops/cycle   LLC misses Bytes/FLOP\n");
+    printf("---------------------------------------------------------------------------\n");
+    for (k = 0; k < modes[mode].nkernels; k++)
+        for (p = 0; p < 2; p++)
+            {
+            c = phase[k][p].count;
+            printf("%-8s %-6s %9.3f",kernel_names[modes[mode].kernels[k]],names[p],
+                   (phase[k][p].time > 0.) ? phase[k][p].flops/phase[k][p].time/1.0e9 : 0.);
+            if (counter_fd[CYCLES] >= 0 && c[CYCLES] > 0)
+                printf(" %10.3f",phase[k][p].flops/c[CYCLES]);
+            else
+                printf(" %10s","-");
+            fpops = 0.;
+            for (e = 0; e < 4; e++)
+                fpops = (counter_fd[FP_OPS+e] >= 0 && fpops >= 0.) ?
+                        fpops + (double)c[FP_OPS+e]*width[e] : -1.;
+            if (counter_fd[CYCLES] >= 0 && c[CYCLES] > 0 && fpops >= 0.)
+                printf(" %12.3f",fpops/c[CYCLES]);
+            else
+                printf(" %12s","-");
+            if (counter_fd[LLC_MISSES] >= 0)
+                printf(" %12lld %10.4f\n",c[LLC_MISSES],
+                       LINE_BYTES*(double)c[LLC_MISSES]/phase[k][p].flops);
+            else
+                printf(" %12s %10s\n","-","-");
+            }
+    }
+
+
+/*
+** Wall-clock time in seconds, from a monotonic clock, in double precision
+** whatever REAL is.
+*/
+static double second(void)
+
+    {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return ((double)now.tv_sec+(double)now.tv_nsec*1e-9);
     }
 
 
@@ -0,0 +1,241 @@
+/*
+** LINPACK_GEMM.H   Register tile of dgemm_b and the batched dgefa_v and
+**                  dgesl_v for linpack.c
+**
+** Included by linpack.c once for each instruction set, like
+** linpack_simd.h, with SIMD_LEVEL set to 1 (SSE2), 2 (AVX2 and FMA) or 3
+** (AVX-512F), or to 0 for the vectors enabled at compile time on other
+** processors.  Each inclusion defines dgemm_kernel_<isa>, dgefa_v_<isa>
+** and dgesl_v_<isa> on GNU C vectors of GBYTES bytes, compiled for that
+** instruction set through a target attribute, for simd_init() to pick.
+** The register tile is NR columns of two vectors, GMR elements, and the
+** batched kernels factor GLANES matrices side by side.
+*/
+
+#if SIMD_LEVEL == 1
+#define GBYTES              16
+#define GNAME(f)            f##_sse2
+#define TARGET              __attribute__((target("sse2")))
+#elif SIMD_LEVEL == 2
+#define GBYTES              32
+#define GNAME(f)            f##_avx2
+#define TARGET              __attribute__((target("avx2,fma")))
+#elif SIMD_LEVEL == 3
+#define GBYTES              64
+#define GNAME(f)            f##_avx512
+#define TARGET              __attribute__((target("avx512f")))
+#else
+#define GBYTES              VBYTES
+#define GNAME(f)            f##_gen
+#define TARGET
+#endif
+#define GMR                 (2*GBYTES/(int)sizeof(REAL))
+#define GLANES              (GBYTES/(int)sizeof(REAL))
+#define VREAL               GNAME(vreal)
+#define VMASK               GNAME(vmask)
+
+typedef REAL VREAL __attribute__((vector_size(GBYTES),aligned(sizeof(REAL))));
+#ifdef SP
+typedef int       VMASK __attribute__((vector_size(GBYTES)));
+#else
+typedef long long VMASK __attribute__((vector_size(GBYTES)));
+#endif
+
+
+/*
+** Register tile of dgemm_b: the GMR x NR block of c at c[0] gets the
+** product of a GMR row sliver of packa and an NR column sliver of packb,
+** of which only the leading m x n part is stored back.  The tile is held
+** in 2*NR named vectors, which the compiler keeps in registers and updates
+** with vector multiply-adds.
+*/
+TARGET static void GNAME(dgemm_kernel)(int k,REAL *pa,REAL *pb,REAL *c,int ldc,int m,int n)
+
+    {
+    VREAL a0,a1;
+    VREAL c00,c01,c10,c11,c20,c21,c30,c31,c40,c41,c50,c51;
+    VREAL ab[2*NR];
+    int i,j,l;
+
+    c00 = c01 = c10 = c11 = c20 = c21 = (VREAL){ZERO};
+    c30 = c31 = c40 = c41 = c50 = c51 = (VREAL){ZERO};
+    for (l = 0; l < k; l++)
+        {
+        a0 = ((VREAL *)pa)[0];
+        a1 = ((VREAL *)pa)[1];
+        c00 += a0*pb[0];
+        c01 += a1*pb[0];
+        c10 += a0*pb[1];
+        c11 += a1*pb[1];
+        c20 += a0*pb[2];
+        c21 += a1*pb[2];
+        c30 += a0*pb[3];
+        c31 += a1*pb[3];
+        c40 += a0*pb[4];
+        c41 += a1*pb[4];
+        c50 += a0*pb[5];
+        c51 += a1*pb[5];
+        pa += GMR;
+        pb += NR;
+        }
+    if (m == GMR && n == NR)
+        {
+        ((VREAL *)&c[0])[0] += c00;
+        ((VREAL *)&c[0])[1] += c01;
+        ((VREAL *)&c[ldc])[0] += c10;
+        ((VREAL *)&c[ldc])[1] += c11;
+        ((VREAL *)&c[2*ldc])[0] += c20;
+        ((VREAL *)&c[2*ldc])[1] += c21;
+        ((VREAL *)&c[3*ldc])[0] += c30;
+        ((VREAL *)&c[3*ldc])[1] += c31;
+        ((VREAL *)&c[4*ldc])[0] += c40;
+        ((VREAL *)&c[4*ldc])[1] += c41;
+        ((VREAL *)&c[5*ldc])[0] += c50;
+        ((VREAL *)&c[5*ldc])[1] += c51;
+        return;
+        }
+    ab[0] = c00; ab[1] = c01; ab[2] = c10; ab[3] = c11;
+    ab[4] = c20; ab[5] = c21; ab[6] = c30; ab[7] = c31;
+    ab[8] = c40; ab[9] = c41; ab[10] = c50; ab[11] = c51;
+    for (j = 0; j < n; j++)
+        for (i = 0; i < m; i++)
+            c[ldc*j+i] += ((REAL *)ab)[GMR*j+i];
+    }
+
+
+/*
+** dgefa and dgesl of the batched mode, on GLANES matrices of order n
+** interleaved as by matgen_v: a is n*n vectors of GLANES elements, the
+** element i,j of all the matrices at a[n*j+i], and b n vectors.  The
+** matrices are factored side by side with the vector operations of GNU C,
+** each with its own pivots: ipvt[GLANES*k+m] is the pivot of step k of
+** matrix m.  Only the interchanges go one matrix at a time.  A zero pivot
+** leaves zero multipliers, so that the column is skipped as in dgefa, and
+** sets info for the group.
+*/
+TARGET static void GNAME(dgefa_v)(REAL *a,int n,int *ipvt,int *info)
+
+    {
+    VREAL *v;
+    VREAL t,t1,vmax,vabs;
+    VMASK sign,gt,zero,vidx;
+    REAL tm;
+    int i,j,k,l,m;
+
+    v = (VREAL *)a;
+    sign = (VMASK)(-(VREAL){ZERO});
+    *info = 0;
+    for (k = 0; k < n-1; k++)
+        {
+
+        /* find the pivot of every matrix, the first of largest magnitude */
+
+        vmax = (VREAL)((VMASK)v[n*k+k] & ~sign);
+        vidx = (VMASK){0} + k;
+        for (i = k+1; i < n; i++)
+            {
+            vabs = (VREAL)((VMASK)v[n*k+i] & ~sign);
+            gt = vabs > vmax;
+            vmax = (VREAL)(((VMASK)vabs & gt) | ((VMASK)vmax & ~gt));
+            vidx = (i & gt) | (vidx & ~gt);
+            }
+
+        /* interchange rows k and l of every matrix */
+
+        for (m = 0; m < GLANES; m++)
+            {
+            l = (int)vidx[m];
+            ipvt[GLANES*k+m] = l;
+            if (l != k)
+                for (j = k; j < n; j++)
+                    {
+                    tm = v[n*j+l][m];
+                    v[n*j+l][m] = v[n*j+k][m];
+                    v[n*j+k][m] = tm;
+                    }
+            }
+
+        /* compute multipliers, and eliminate */
+
+        zero = v[n*k+k] == (REAL)ZERO;
+        for (m = 0; m < GLANES; m++)
+            if (zero[m])
+                *info = k;
+        t = (VREAL)((VMASK)(-(REAL)ONE/v[n*k+k]) & ~zero);
+        for (i = k+1; i < n; i++)
+            v[n*k+i] = t*v[n*k+i];
+        for (j = k+1; j + 1 < n; j += 2)
+            {
+            t = v[n*j+k];
+            t1 = v[n*(j+1)+k];
+            for (i = k+1; i < n; i++)
+                {
+                v[n*j+i] += t*v[n*k+i];
+                v[n*(j+1)+i] += t1*v[n*k+i];
+                }
+            }
+        if (j < n)
+            {
+            t = v[n*j+k];
+            for (i = k+1; i < n; i++)
+                v[n*j+i] += t*v[n*k+i];
+            }
+        }
+    for (m = 0; m < GLANES; m++)
+        {
+        ipvt[GLANES*(n-1)+m] = n-1;
+        if (v[n*(n-1)+(n-1)][m] == ZERO)
+            *info = n-1;
+        }
+    }
+
+
+TARGET static void GNAME(dgesl_v)(REAL *a,int n,int *ipvt,REAL *b)
+
+    {
+    VREAL *v,*vb;
+    VREAL t;
+    REAL tm;
+    int i,k,l,m;
+
+    v = (VREAL *)a;
+    vb = (VREAL *)b;
+
+    /* solve l*y = b */
+
+    for (k = 0; k < n-1; k++)
+        {
+        for (m = 0; m < GLANES; m++)
+            {
+            l = ipvt[GLANES*k+m];
+            if (l != k)
+                {
+                tm = vb[l][m];
+                vb[l][m] = vb[k][m];
+                vb[k][m] = tm;
+                }
+            }
+        t = vb[k];
+        for (i = k+1; i < n; i++)
+            vb[i] += t*v[n*k+i];
+        }
+
+    /* solve u*x = y */
+
+    for (k = n-1; k >= 0; k--)
+        {
+        vb[k] = vb[k]/v[n*k+k];
+        t = -vb[k];
+        for (i = 0; i < k; i++)
+            vb[i] += t*v[n*k+i];
+        }
+    }
+
+
+#undef GBYTES
+#undef GNAME
+#undef TARGET
+#undef GMR
+#undef GLANES
+#undef VREAL
+#undef VMASK
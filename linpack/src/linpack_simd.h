@@ -0,0 +1,279 @@
+/*
+** LINPACK_SIMD.H   Vectorized daxpy, ddot, dscal and idamax for linpack.c
+**
+** Included by linpack.c once for each instruction set, with SIMD_LEVEL
+** set to 1 (SSE2), 2 (AVX2 and FMA) or 3 (AVX-512F), after REAL and the
+** unrolled kernels are declared.  Each inclusion defines daxpy_<isa>,
+** ddot_<isa>, dscal_<isa> and idamax_<isa>, compiled for that instruction
+** set through a target attribute, so that one binary carries all of them
+** and simd_init() picks the best one the processor supports.
+**
+** The vector operations below map to the intrinsics of the instruction
+** set and of the precision of REAL (the _ps or _pd forms):
+**
+**   VT, VM         vector of VR and comparison mask types
+**   VL             number of VR in a vector
+**   vload, vstore  unaligned load and store
+**   vfma(a,b,c)    a*b+c, a multiply and an add without FMA
+**   vabs(a)        absolute value
+**   vgt(a,b)       mask of the lanes with a > b
+**   vblend(m,a,b)  a in the lanes set in m, b elsewhere
+**
+** Non-unit increments are passed on to the unrolled versions.
+**
+** With SIMD_SINGLE defined as well, a double precision build gets the
+** single precision saxpy_<isa>, sscal_<isa> and isamax_<isa> instead, for
+** the factorization of the mixed precision mode; they fall back on the
+** rolled saxpy_r, sscal_r and isamax.  VR is the element type, and
+** VPICK(d,s) picks the double or the single name.
+*/
+
+#if defined(SP) || defined(SIMD_SINGLE)
+#define VSUF                ps
+#else
+#define VSUF                pd
+#endif
+#ifdef SIMD_SINGLE
+#define VR                  float
+#define VPICK(d,s)          s
+#else
+#define VR                  REAL
+#define VPICK(d,s)          d
+#endif
+#define VCAT2(a,b)          a##b
+#define VXCAT2(a,b)         VCAT2(a,b)
+#define VCAT(p,o,s)         p##o##_##s
+#define VXCAT(p,o,s)        VCAT(p,o,s)
+#define VCAT4(p,o,s,t)      p##o##_##s##t
+#define VXCAT4(p,o,s,t)     VCAT4(p,o,s,t)
+#define VOP(o)              VXCAT(VPRE,o,VSUF)
+
+#if SIMD_LEVEL == 1
+
+#define VNAME(d,s)          VXCAT2(VPICK(d,s),_sse2)
+#define TARGET              __attribute__((target("sse2")))
+#define VPRE                _mm_
+#if defined(SP) || defined(SIMD_SINGLE)
+#define VT                  __m128
+#else
+#define VT                  __m128d
+#endif
+#define VM                  VT
+#define vfma(a,b,c)         VOP(add)(VOP(mul)(a,b),c)
+#define vabs(a)             VOP(andnot)(VOP(set1)(-ZERO),a)
+#define vgt(a,b)            VOP(cmpgt)(a,b)
+#define vblend(m,a,b)       VOP(or)(VOP(and)(m,a),VOP(andnot)(m,b))
+
+#elif SIMD_LEVEL == 2
+
+#define VNAME(d,s)          VXCAT2(VPICK(d,s),_avx2)
+#define TARGET              __attribute__((target("avx2,fma")))
+#define VPRE                _mm256_
+#if defined(SP) || defined(SIMD_SINGLE)
+#define VT                  __m256
+#else
+#define VT                  __m256d
+#endif
+#define VM                  VT
+#define vfma(a,b,c)         VOP(fmadd)(a,b,c)
+#define vabs(a)             VOP(andnot)(VOP(set1)(-ZERO),a)
+#define vgt(a,b)            VOP(cmp)(a,b,_CMP_GT_OQ)
+#define vblend(m,a,b)       VOP(blendv)(b,a,m)
+
+#else
+
+#define VNAME(d,s)          VXCAT2(VPICK(d,s),_avx512)
+#define TARGET              __attribute__((target("avx512f")))
+#define VPRE                _mm512_
+#if defined(SP) || defined(SIMD_SINGLE)
+#define VT                  __m512
+#define VM                  __mmask16
+#else
+#define VT                  __m512d
+#define VM                  __mmask8
+#endif
+#define vfma(a,b,c)         VOP(fmadd)(a,b,c)
+#define vabs(a)             VOP(abs)(a)
+#define vgt(a,b)            VXCAT4(VPRE,cmp,VSUF,_mask)(a,b,_CMP_GT_OQ)
+#define vblend(m,a,b)       VOP(mask_blend)(m,b,a)
+
+#endif
+
+#define VL                  (int)(sizeof(VT)/sizeof(VR))
+#define vload(p)            VOP(loadu)(p)
+#define vstore(p,a)         VOP(storeu)(p,a)
+
+
+/*
+** dy = dy + da*dx, four vectors per iteration.
+*/
+TARGET static void VNAME(daxpy,saxpy)(int n,VR da,VR *dx,int incx,VR *dy,int incy)
+
+    {
+    VT a;
+    int i;
+
+    if (n <= 0)
+        return;
+    if (da == ZERO)
+        return;
+    if (incx != 1 || incy != 1)
+        {
+        VPICK(daxpy_ur,saxpy_r)(n,da,dx,incx,dy,incy);
+        return;
+        }
+    a = VOP(set1)(da);
+    for (i = 0; i + 4*VL <= n; i += 4*VL)
+        {
+        vstore(&dy[i],     vfma(a,vload(&dx[i]),     vload(&dy[i])));
+        vstore(&dy[i+VL],  vfma(a,vload(&dx[i+VL]),  vload(&dy[i+VL])));
+        vstore(&dy[i+2*VL],vfma(a,vload(&dx[i+2*VL]),vload(&dy[i+2*VL])));
+        vstore(&dy[i+3*VL],vfma(a,vload(&dx[i+3*VL]),vload(&dy[i+3*VL])));
+        }
+    for (; i + VL <= n; i += VL)
+        vstore(&dy[i],vfma(a,vload(&dx[i]),vload(&dy[i])));
+    for (; i < n; i++)
+        dy[i] = dy[i] + da*dx[i];
+    }
+
+
+#ifndef SIMD_SINGLE
+/*
+** Dot product of dx and dy, in four independent accumulators so that the
+** latency of the additions is hidden.
+*/
+TARGET static REAL VNAME(ddot,sdot)(int n,REAL *dx,int incx,REAL *dy,int incy)
+
+    {
+    VT s0,s1,s2,s3;
+    REAL s[64/sizeof(REAL)];
+    REAL dtemp;
+    int i;
+
+    if (n <= 0)
+        return(ZERO);
+    if (incx != 1 || incy != 1)
+        return(ddot_ur(n,dx,incx,dy,incy));
+    s0 = s1 = s2 = s3 = VOP(setzero)();
+    for (i = 0; i + 4*VL <= n; i += 4*VL)
+        {
+        s0 = vfma(vload(&dx[i]),     vload(&dy[i]),     s0);
+        s1 = vfma(vload(&dx[i+VL]),  vload(&dy[i+VL]),  s1);
+        s2 = vfma(vload(&dx[i+2*VL]),vload(&dy[i+2*VL]),s2);
+        s3 = vfma(vload(&dx[i+3*VL]),vload(&dy[i+3*VL]),s3);
+        }
+    for (; i + VL <= n; i += VL)
+        s0 = vfma(vload(&dx[i]),vload(&dy[i]),s0);
+    vstore(s,VOP(add)(VOP(add)(s0,s1),VOP(add)(s2,s3)));
+    dtemp = ZERO;
+    for (; i < n; i++)
+        dtemp = dtemp + dx[i]*dy[i];
+    for (i = 0; i < VL; i++)
+        dtemp = dtemp + s[i];
+    return(dtemp);
+    }
+#endif
+
+
+/*
+** dx = da*dx.
+*/
+TARGET static void VNAME(dscal,sscal)(int n,VR da,VR *dx,int incx)
+
+    {
+    VT a;
+    int i;
+
+    if (n <= 0)
+        return;
+    if (incx != 1)
+        {
+        VPICK(dscal_ur,sscal_r)(n,da,dx,incx);
+        return;
+        }
+    a = VOP(set1)(da);
+    for (i = 0; i + 2*VL <= n; i += 2*VL)
+        {
+        vstore(&dx[i],   VOP(mul)(a,vload(&dx[i])));
+        vstore(&dx[i+VL],VOP(mul)(a,vload(&dx[i+VL])));
+        }
+    for (; i + VL <= n; i += VL)
+        vstore(&dx[i],VOP(mul)(a,vload(&dx[i])));
+    for (; i < n; i++)
+        dx[i] = da*dx[i];
+    }
+
+
+/*
+** Index of the first element of largest absolute value.  Every lane keeps
+** its largest value and, as a VR, the index it was found at; only a
+** strictly larger value replaces them, so each lane holds the first of
+** its maxima.  The lanes are then merged, the smallest index winning ties,
+** and the leftover elements checked one by one.
+*/
+TARGET static int VNAME(idamax,isamax)(int n,VR *dx,int incx)
+
+    {
+    VT v,vmax,vidx,cur,step;
+    VM m;
+    VR smax[64/sizeof(VR)],sidx[64/sizeof(VR)];
+    VR dmax;
+    int i,itemp;
+
+    if (incx != 1 || n < 2*VL)
+        return(VPICK(idamax,isamax)(n,dx,incx));
+    for (i = 0; i < VL; i++)
+        sidx[i] = (VR)i;
+    vidx = cur = vload(sidx);
+    step = VOP(set1)((VR)VL);
+    vmax = vabs(vload(dx));
+    for (i = VL; i + VL <= n; i += VL)
+        {
+        cur = VOP(add)(cur,step);
+        v = vabs(vload(&dx[i]));
+        m = vgt(v,vmax);
+        vmax = vblend(m,v,vmax);
+        vidx = vblend(m,cur,vidx);
+        }
+    vstore(smax,vmax);
+    vstore(sidx,vidx);
+    dmax = smax[0];
+    itemp = (int)sidx[0];
+    for (i = 1; i < VL; i++)
+        if (smax[i] > dmax || (smax[i] == dmax && (int)sidx[i] < itemp))
+            {
+            dmax = smax[i];
+            itemp = (int)sidx[i];
+            }
+    for (i = n - n%VL; i < n; i++)
+        if (fabs((double)dx[i]) > dmax)
+            {
+            itemp = i;
+            dmax = fabs((double)dx[i]);
+            }
+    return(itemp);
+    }
+
+
+#undef VNAME
+#undef TARGET
+#undef VPRE
+#undef VT
+#undef VM
+#undef VL
+#undef vfma
+#undef vabs
+#undef vgt
+#undef vblend
+#undef vload
+#undef vstore
+#undef VR
+#undef VPICK
+#undef VCAT2
+#undef VXCAT2
+#undef VSUF
+#undef VCAT
+#undef VXCAT
+#undef VCAT4
+#undef VXCAT4
+#undef VOP